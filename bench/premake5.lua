@@ -0,0 +1,20 @@
+local raytracer_bench = {}
+
+raytracer_bench.name = "raytracer_bench"
+raytracer_bench.path = "./bench"
+raytracer_bench.kind = "ConsoleApp"
+raytracer_bench.language = "C++"
+raytracer_bench.dialect = "C++latest"
+
+raytracer_bench.files = function()
+  files { "./src/**.cpp" , "./src/**.hpp" }
+end
+
+raytracer_bench.include_dirs = function()
+  includedirs { "./src" }
+end
+
+raytracer_bench.components = {}
+raytracer_bench.components["raytracer"] = { "%{wks.location}/raytracer/src" }
+
+AddProject(raytracer_bench)
@@ -0,0 +1,153 @@
+/**
+ * \file alloc_check.cpp
+ **/
+#include "bench.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+#include "scene_loader.hpp"
+
+/// heap allocations of every thread but the one that started counting , i.e. the render
+///   workers while the camera renders
+static std::atomic<bool> counting{ false };
+static std::atomic<uint64_t> num_allocations{ 0 };
+static thread_local bool is_counting_thread = false;
+
+static void CountAllocation() {
+  if (counting.load(std::memory_order_relaxed) && !is_counting_thread) {
+    num_allocations.fetch_add(1 , std::memory_order_relaxed);
+  }
+}
+
+static void* Allocate(std::size_t size) {
+  CountAllocation();
+
+  void* ptr = std::malloc(size > 0 ? size : 1);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+static void* AllocateAligned(std::size_t size , std::align_val_t align) {
+  CountAllocation();
+
+  std::size_t alignment = std::size_t(align);
+  size = (size + alignment - 1) & ~(alignment - 1);
+#ifdef _MSC_VER
+  void* ptr = _aligned_malloc(size > 0 ? size : alignment , alignment);
+#else
+  void* ptr = std::aligned_alloc(alignment , size > 0 ? size : alignment);
+#endif
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+static void FreeAligned(void* ptr) {
+#ifdef _MSC_VER
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+
+/// every replaceable form , so whatever the library or the standard library allocates with
+///   is counted and freed by the matching function
+void* operator new(std::size_t size) { return Allocate(size); }
+void* operator new[](std::size_t size) { return Allocate(size); }
+void* operator new(std::size_t size , std::align_val_t align) { return AllocateAligned(size , align); }
+void* operator new[](std::size_t size , std::align_val_t align) { return AllocateAligned(size , align); }
+
+void* operator new(std::size_t size , const std::nothrow_t&) noexcept {
+  try { return Allocate(size); } catch (...) { return nullptr; }
+}
+
+void* operator new[](std::size_t size , const std::nothrow_t&) noexcept {
+  try { return Allocate(size); } catch (...) { return nullptr; }
+}
+
+void* operator new(std::size_t size , std::align_val_t align , const std::nothrow_t&) noexcept {
+  try { return AllocateAligned(size , align); } catch (...) { return nullptr; }
+}
+
+void* operator new[](std::size_t size , std::align_val_t align , const std::nothrow_t&) noexcept {
+  try { return AllocateAligned(size , align); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr , std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr , std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr , const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr , const std::nothrow_t&) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr , std::align_val_t) noexcept { FreeAligned(ptr); }
+void operator delete[](void* ptr , std::align_val_t) noexcept { FreeAligned(ptr); }
+void operator delete(void* ptr , std::size_t , std::align_val_t) noexcept { FreeAligned(ptr); }
+void operator delete[](void* ptr , std::size_t , std::align_val_t) noexcept { FreeAligned(ptr); }
+void operator delete(void* ptr , std::align_val_t , const std::nothrow_t&) noexcept { FreeAligned(ptr); }
+void operator delete[](void* ptr , std::align_val_t , const std::nothrow_t&) noexcept { FreeAligned(ptr); }
+
+/// scene of the render allocation check , it has every material , textures , a medium ,
+///   moving spheres and instances
+static const char* alloc_check_scene = "final_scene";
+
+bool RunAllocationChecks(const SceneBenchOptions& options) {
+  /// the camera reports every stage , only the count is wanted here
+  std::ostringstream log;
+  std::streambuf* cout_buffer = std::cout.rdbuf(log.rdbuf());
+
+  ThreadRng() = Rng();
+
+  SceneDescription scene;
+  bool loaded = LoadScene(options.scene_dir + "/" + alloc_check_scene + ".scene" , scene);
+
+  uint64_t allocations = 0;
+  if (loaded) {
+    Camera& cam = scene.camera;
+    cam.img_width = 64;
+    cam.samples_per_pixel = 4;
+    cam.seed = options.seed;
+    /// the image stays in memory , the check leaves nothing under images/
+    cam.img_file = "";
+
+    /// a single worker sees every tile in both renders , with several of them a tile could
+    ///   land on a worker whose buffers the warm up didn't grow yet
+    cam.num_threads = 1;
+
+    /// the warm up grows the per thread arenas , tile buffers and stats slots
+    scene.Render();
+
+    is_counting_thread = true;
+    num_allocations.store(0);
+    counting.store(true);
+
+    scene.Render();
+
+    counting.store(false);
+    is_counting_thread = false;
+    allocations = num_allocations.load();
+  }
+
+  std::cout.rdbuf(cout_buffer);
+
+  if (!loaded) {
+    std::cerr << "ERROR : Failed to load the allocation check scene : " << alloc_check_scene << "\n";
+    return false;
+  }
+
+  std::cout << "Allocation check : " << allocations << " heap allocations on the render workers of a warmed up "
+            << alloc_check_scene << " render\n";
+  if (allocations != 0) {
+    std::cerr << "ERROR : Rendering allocated on the workers after warm up : " << allocations << " allocations\n";
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,129 @@
+/**
+ * \file bench.cpp
+ **/
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+static volatile double optimizer_sink = 0.0;
+
+void DoNotOptimize(double value) {
+  optimizer_sink = value;
+}
+
+BenchSuite::BenchSuite(const std::string& filter , double min_sample_time , uint32_t num_samples)
+    : filter(filter) , min_sample_time(min_sample_time) , num_samples(std::max(num_samples , 1u)) {}
+
+bool BenchSuite::Enabled(const std::string& name) const {
+  return filter.empty() || name.find(filter) != std::string::npos;
+}
+
+void BenchSuite::AddResult(const BenchResult& result) {
+  results.push_back(result);
+  PrintResult(result);
+}
+
+const std::vector<BenchResult>& BenchSuite::Results() const {
+  return results;
+}
+
+void BenchSuite::PrintTable() const {
+  for (const BenchResult& result : results) {
+    PrintResult(result);
+  }
+}
+
+void BenchSuite::PrintResult(const BenchResult& result) {
+  char line[256];
+  std::snprintf(line , sizeof(line) , "%-32s %14.2f ns/op  (min %.2f , %llu x %u)" , result.name.c_str() ,
+                result.ns_per_op , result.min_ns_per_op , (unsigned long long)result.iterations , result.samples);
+  std::cout << line;
+
+  for (const BenchMetric& metric : result.metrics) {
+    std::cout << "  " << metric.name << " " << metric.value;
+  }
+  std::cout << "\n";
+}
+
+/// names are plain identifiers , only quotes and backslashes would need escaping
+static std::string JsonString(const std::string& str) {
+  std::string out = "\"";
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+    }
+    out += c;
+  }
+  return out + "\"";
+}
+
+static std::string JsonNumber(double value) {
+  char buffer[64];
+  std::snprintf(buffer , sizeof(buffer) , "%.6g" , value);
+  return buffer;
+}
+
+bool BenchSuite::WriteJson(const std::string& file_name) const {
+  std::ofstream file(file_name);
+  if (!file.is_open()) {
+    std::cerr << "ERROR : Failed to open benchmark output : " << file_name << "\n";
+    return false;
+  }
+
+#ifdef NDEBUG
+  const char* build = "release";
+#else
+  const char* build = "debug";
+#endif
+
+  file << "{\n";
+  file << "  \"version\" : 1 ,\n";
+  file << "  \"build\" : " << JsonString(build) << " ,\n";
+  file << "  \"hardware_threads\" : " << std::thread::hardware_concurrency() << " ,\n";
+  file << "  \"results\" : [\n";
+
+  for (size_t i = 0; i < results.size(); ++i) {
+    const BenchResult& result = results[i];
+    file << "    { \"name\" : " << JsonString(result.name) << " , \"group\" : " << JsonString(result.group)
+         << " , \"iterations\" : " << result.iterations << " , \"samples\" : " << result.samples
+         << " , \"ns_per_op\" : " << JsonNumber(result.ns_per_op)
+         << " , \"min_ns_per_op\" : " << JsonNumber(result.min_ns_per_op);
+
+    for (const BenchMetric& metric : result.metrics) {
+      file << " , " << JsonString(metric.name) << " : " << JsonNumber(metric.value);
+    }
+
+    file << " }" << (i + 1 < results.size() ? " ," : "") << "\n";
+  }
+
+  file << "  ]\n";
+  file << "}\n";
+
+  if (!file) {
+    std::cerr << "ERROR : Failed to write benchmark output : " << file_name << "\n";
+    return false;
+  }
+
+  return true;
+}
+
+BenchResult BenchSuite::MakeResult(const std::string& name , const std::string& group , uint64_t iterations ,
+                                   std::vector<double> sample_ns) {
+  BenchResult result;
+  result.name = name;
+  result.group = group;
+  result.iterations = iterations;
+  result.samples = uint32_t(sample_ns.size());
+
+  if (!sample_ns.empty()) {
+    std::sort(sample_ns.begin() , sample_ns.end());
+    result.ns_per_op = sample_ns[sample_ns.size() / 2];
+    result.min_ns_per_op = sample_ns.front();
+  }
+
+  return result;
+}
@@ -0,0 +1,129 @@
+/**
+ * \file bench.hpp
+ **/
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// extra numbers a benchmark reports next to its timing , e.g. rays/s of a scene run
+class BenchMetric {
+  public:
+    std::string name;
+    double value;
+};
+
+class BenchResult {
+  public:
+    std::string name;
+    /// "micro" or "scene"
+    std::string group;
+
+    /// operations timed per sample and the number of samples
+    uint64_t iterations = 0;
+    uint32_t samples = 0;
+
+    /// median and fastest sample , the median is what regressions are judged on
+    double ns_per_op = 0.0;
+    double min_ns_per_op = 0.0;
+
+    std::vector<BenchMetric> metrics{};
+};
+
+/// keeps the compiler from dropping a result that is never used
+void DoNotOptimize(double value);
+
+/// times benchmarks and collects their results. a benchmark body runs a given number of
+///   operations and returns something derived from their results , the iteration count
+///   is doubled until one sample takes min_sample_time and the median of several samples
+///   is reported
+class BenchSuite {
+  public:
+    BenchSuite(const std::string& filter , double min_sample_time , uint32_t num_samples);
+
+    /// false when name doesn't contain the filter
+    bool Enabled(const std::string& name) const;
+
+    template <typename Func>
+    void Run(const std::string& name , Func&& body) {
+      if (!Enabled(name)) {
+        return;
+      }
+
+      /// calibrate , the warmup also faults in whatever the body touches
+      uint64_t iterations = 1;
+      while (true) {
+        double seconds = TimeBody(body , iterations);
+        if (seconds >= min_sample_time || iterations >= (uint64_t(1) << 40)) {
+          break;
+        }
+
+        iterations *= (seconds > 0.0 && min_sample_time / seconds < 2.0) ?
+          2 : ((seconds > 0.0 && min_sample_time / seconds < 16.0) ? 4 : 16);
+      }
+
+      std::vector<double> sample_ns;
+      for (uint32_t s = 0; s < num_samples; ++s) {
+        sample_ns.push_back(TimeBody(body , iterations) * 1e9 / double(iterations));
+      }
+
+      AddResult(MakeResult(name , "micro" , iterations , sample_ns));
+    }
+
+    /// prints it as well
+    void AddResult(const BenchResult& result);
+
+    const std::vector<BenchResult>& Results() const;
+
+    /// one line per result
+    void PrintTable() const;
+
+    bool WriteJson(const std::string& file_name) const;
+
+    static BenchResult MakeResult(const std::string& name , const std::string& group , uint64_t iterations ,
+                                  std::vector<double> sample_ns);
+
+  private:
+    std::string filter;
+    double min_sample_time;
+    uint32_t num_samples;
+
+    std::vector<BenchResult> results{};
+
+    static void PrintResult(const BenchResult& result);
+
+    template <typename Func>
+    static double TimeBody(Func& body , uint64_t iterations) {
+      std::chrono::time_point<std::chrono::steady_clock> before = std::chrono::steady_clock::now();
+      DoNotOptimize(double(body(iterations)));
+      std::chrono::time_point<std::chrono::steady_clock> after = std::chrono::steady_clock::now();
+
+      return std::chrono::duration<double>(after - before).count();
+    }
+};
+
+/// microbenchmarks of the hit tests , bvh builds and traversal , noise , textures and pdfs
+void RunMicroBenchmarks(BenchSuite& suite);
+
+class SceneBenchOptions {
+  public:
+    std::string scene_dir = "scenes";
+    uint32_t img_width = 200;
+    uint32_t samples_per_pixel = 16;
+    uint32_t num_threads = 0;
+    uint64_t seed = 0;
+};
+
+/// end to end renders of the reference scenes at a fixed seed and a reduced size
+void RunSceneBenchmarks(BenchSuite& suite , const SceneBenchOptions& options);
+
+/// renders a fixed scene twice on one worker and fails when the second render allocates on
+///   it , i.e. anywhere under Camera::RenderTile. the bench replaces the global operator new
+///   to count
+bool RunAllocationChecks(const SceneBenchOptions& options);
+
+#endif // !BENCH_HPP
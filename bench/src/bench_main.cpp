@@ -0,0 +1,90 @@
+/**
+ * \file bench_main.cpp
+ **/
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+static void PrintUsage() {
+  std::cout << "usage : raytracer_bench [options]\n"
+            << "  --filter <text>       only benchmarks whose name contains text\n"
+            << "  --json <file>         results file , default bench_results.json\n"
+            << "  --min-time <seconds>  minimum length of one timed sample , default 0.1\n"
+            << "  --samples <n>         timed samples per microbenchmark , default 5\n"
+            << "  --no-micro            skip the microbenchmarks\n"
+            << "  --no-scenes           skip the scene renders\n"
+            << "  --no-checks           skip the render allocation check\n"
+            << "  --scenes <dir>        directory of the reference scenes , default scenes\n"
+            << "  --width <px>          scene render width , default 200\n"
+            << "  --spp <n>             scene samples per pixel , default 16\n"
+            << "  --threads <n>         scene render threads , default every hardware thread\n"
+            << "  --seed <n>            scene sample seed , default 0\n";
+}
+
+/// run from the repository root so scenes/ and images/ resolve
+int main(int argc , char* argv[]) {
+  std::string filter = "";
+  std::string json_file = "bench_results.json";
+  double min_time = 0.1;
+  uint32_t num_samples = 5;
+  bool run_micro = true;
+  bool run_scenes = true;
+  bool run_checks = true;
+  SceneBenchOptions scene_options;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (arg == "--filter" && has_value) {
+      filter = argv[++i];
+    } else if (arg == "--json" && has_value) {
+      json_file = argv[++i];
+    } else if (arg == "--min-time" && has_value) {
+      min_time = std::atof(argv[++i]);
+    } else if (arg == "--samples" && has_value) {
+      num_samples = uint32_t(std::atoi(argv[++i]));
+    } else if (arg == "--no-micro") {
+      run_micro = false;
+    } else if (arg == "--no-scenes") {
+      run_scenes = false;
+    } else if (arg == "--no-checks") {
+      run_checks = false;
+    } else if (arg == "--scenes" && has_value) {
+      scene_options.scene_dir = argv[++i];
+    } else if (arg == "--width" && has_value) {
+      scene_options.img_width = uint32_t(std::atoi(argv[++i]));
+    } else if (arg == "--spp" && has_value) {
+      scene_options.samples_per_pixel = uint32_t(std::atoi(argv[++i]));
+    } else if (arg == "--threads" && has_value) {
+      scene_options.num_threads = uint32_t(std::atoi(argv[++i]));
+    } else if (arg == "--seed" && has_value) {
+      scene_options.seed = std::strtoull(argv[++i] , nullptr , 10);
+    } else {
+      PrintUsage();
+      return (arg == "--help" || arg == "-h") ? 0 : 1;
+    }
+  }
+
+  /// a failed check fails the run but the timings are still written
+  bool checks_passed = !run_checks || RunAllocationChecks(scene_options);
+
+  BenchSuite suite(filter , min_time , num_samples);
+
+  if (run_micro) {
+    RunMicroBenchmarks(suite);
+  }
+
+  if (run_scenes) {
+    RunSceneBenchmarks(suite , scene_options);
+  }
+
+  if (!suite.WriteJson(json_file)) {
+    return 1;
+  }
+
+  std::cout << "\n" << suite.Results().size() << " results written to " << json_file << "\n";
+  return checks_passed ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+/**
+ * \file micro_bench.cpp
+ **/
+#include "bench.hpp"
+
+#include "aabb.hpp"
+#include "bvh.hpp"
+#include "compiled_scene.hpp"
+#include "hittable_list.hpp"
+#include "material.hpp"
+#include "pdf.hpp"
+#include "perlin.hpp"
+#include "quad.hpp"
+#include "sphere.hpp"
+#include "texture.hpp"
+#include "wide_bvh.hpp"
+
+/// inputs are drawn once from a fixed stream and cycled through , so the timed loops measure
+///   the code under test and not the rng
+static constexpr uint32_t num_inputs = 1024;
+static constexpr uint32_t input_mask = num_inputs - 1;
+
+static constexpr uint32_t num_bvh_prims = 10000;
+
+/// rays from a shell around the origin aimed at points inside [-1 , 1]^3 , most of them hit
+///   unit sized primitives at the origin
+static std::vector<Ray> MakeRays(double shell_radius , double target_radius) {
+  Rng rng(0x5eed);
+  auto uniform = [&rng](double min , double max) {
+    return min + (max - min) * rng.NextDouble();
+  };
+
+  std::vector<Ray> rays;
+  rays.reserve(num_inputs);
+  for (uint32_t i = 0; i < num_inputs; ++i) {
+    glm::vec3 origin(uniform(-1 , 1) , uniform(-1 , 1) , uniform(-1 , 1));
+    origin = float(shell_radius) * UnitVector(origin);
+
+    glm::vec3 target(uniform(-1 , 1) , uniform(-1 , 1) , uniform(-1 , 1));
+    target *= float(target_radius);
+
+    rays.emplace_back(origin , UnitVector(target - origin) , 0.0);
+  }
+
+  return rays;
+}
+
+static std::vector<Point3> MakePoints(double scale) {
+  Rng rng(0x9017);
+
+  std::vector<Point3> points;
+  points.reserve(num_inputs);
+  for (uint32_t i = 0; i < num_inputs; ++i) {
+    points.emplace_back(scale * rng.NextDouble() , scale * rng.NextDouble() , scale * rng.NextDouble());
+  }
+
+  return points;
+}
+
+static std::vector<glm::vec3> MakeDirections() {
+  Rng rng(0xd12);
+
+  std::vector<glm::vec3> dirs;
+  dirs.reserve(num_inputs);
+  while (dirs.size() < num_inputs) {
+    glm::vec3 d(2.0 * rng.NextDouble() - 1.0 , 2.0 * rng.NextDouble() - 1.0 , 2.0 * rng.NextDouble() - 1.0);
+    if (LengthSquared(d) > 1e-4 && LengthSquared(d) <= 1.0) {
+      dirs.push_back(UnitVector(d));
+    }
+  }
+
+  return dirs;
+}
+
+/// small spheres scattered through a cube of side 20 , the shape of a typical instanced scene
+static HittableList MakeSphereField(const Ref<Material>& mat) {
+  Rng rng(0xb7);
+
+  HittableList list;
+  for (uint32_t i = 0; i < num_bvh_prims; ++i) {
+    Point3 center(20.0 * rng.NextDouble() - 10.0 , 20.0 * rng.NextDouble() - 10.0 , 20.0 * rng.NextDouble() - 10.0);
+    list.Add(NewRef<Sphere>(center , 0.1 + 0.2 * rng.NextDouble() , mat));
+  }
+
+  return list;
+}
+
+template <typename Func>
+static void RunHitBench(BenchSuite& suite , const std::string& name , const std::vector<Ray>& rays , Func&& hit) {
+  suite.Run(name , [&rays , &hit](uint64_t iterations) {
+    uint64_t hits = 0;
+    for (uint64_t i = 0; i < iterations; ++i) {
+      hits += hit(rays[i & input_mask]) ? 1 : 0;
+    }
+    return double(hits);
+  });
+}
+
+template <typename Func>
+static void RunPointBench(BenchSuite& suite , const std::string& name , const std::vector<Point3>& points , Func&& eval) {
+  suite.Run(name , [&points , &eval](uint64_t iterations) {
+    double sum = 0.0;
+    for (uint64_t i = 0; i < iterations; ++i) {
+      sum += eval(points[i & input_mask]);
+    }
+    return sum;
+  });
+}
+
+static void RunPdfBench(BenchSuite& suite , const std::string& name , const Pdf& pdf , const std::vector<glm::vec3>& dirs) {
+  suite.Run(name + "_generate" , [&pdf](uint64_t iterations) {
+    double sum = 0.0;
+    for (uint64_t i = 0; i < iterations; ++i) {
+      sum += pdf.Generate().x;
+    }
+    return sum;
+  });
+
+  suite.Run(name + "_value" , [&pdf , &dirs](uint64_t iterations) {
+    double sum = 0.0;
+    for (uint64_t i = 0; i < iterations; ++i) {
+      sum += pdf.Value(dirs[i & input_mask]);
+    }
+    return sum;
+  });
+}
+
+void RunMicroBenchmarks(BenchSuite& suite) {
+  auto mat = NewRef<Lambertian>(Color(0.5 , 0.5 , 0.5));
+  std::vector<Ray> rays = MakeRays(4.0 , 1.5);
+
+  /// primitives
+  Aabb box(Point3(-1 , -1 , -1) , Point3(1 , 1 , 1));
+  RunHitBench(suite , "aabb_hit" , rays , [&box](const Ray& r) {
+    return box.Hit(r , Interval(0.001 , infinity));
+  });
+
+  Sphere sphere(Point3(0 , 0 , 0) , 1.0 , mat);
+  RunHitBench(suite , "sphere_hit" , rays , [&sphere](const Ray& r) {
+    HitRecord rec;
+    return sphere.Hit(r , Interval(0.001 , infinity) , rec);
+  });
+
+  Quad quad(Point3(-1 , -1 , 0) , glm::vec3(2 , 0 , 0) , glm::vec3(0 , 2 , 0) , mat);
+  RunHitBench(suite , "quad_hit" , rays , [&quad](const Ray& r) {
+    HitRecord rec;
+    return quad.Hit(r , Interval(0.001 , infinity) , rec);
+  });
+
+  /// acceleration structures over the same sphere field , one op is a whole build
+  HittableList field = MakeSphereField(mat);
+  std::vector<Ray> field_rays = MakeRays(30.0 , 10.0);
+
+  auto run_build = [&suite](const std::string& name , auto&& build) {
+    suite.Run(name , [&build](uint64_t iterations) {
+      double sum = 0.0;
+      for (uint64_t i = 0; i < iterations; ++i) {
+        sum += build();
+      }
+      return sum;
+    });
+  };
+
+  run_build("bvh_node_build" , [&field]() {
+    return BvhNode(field).BoundingBox().x.min;
+  });
+  run_build("wide_bvh_build" , [&field]() {
+    return WideBvh(field).BoundingBox().x.min;
+  });
+  run_build("compiled_scene_build" , [&field]() {
+    return CompiledScene(field).BoundingBox().x.min;
+  });
+
+  if (suite.Enabled("bvh_node_hit")) {
+    BvhNode bvh(field);
+    RunHitBench(suite , "bvh_node_hit" , field_rays , [&bvh](const Ray& r) {
+      HitRecord rec;
+      return bvh.Hit(r , Interval(0.001 , infinity) , rec);
+    });
+  }
+
+  if (suite.Enabled("wide_bvh_hit")) {
+    WideBvh bvh(field);
+    RunHitBench(suite , "wide_bvh_hit" , field_rays , [&bvh](const Ray& r) {
+      HitRecord rec;
+      return bvh.Hit(r , Interval(0.001 , infinity) , rec);
+    });
+  }
+
+  if (suite.Enabled("compiled_scene_hit")) {
+    CompiledScene compiled(field);
+    RunHitBench(suite , "compiled_scene_hit" , field_rays , [&compiled](const Ray& r) {
+      HitRecord rec;
+      return compiled.Hit(r , Interval(0.001 , infinity) , rec);
+    });
+  }
+
+  /// textures
+  std::vector<Point3> points = MakePoints(16.0);
+
+  Perlin perlin;
+  RunPointBench(suite , "perlin_noise" , points , [&perlin](const Point3& p) {
+    return perlin.Noise(p);
+  });
+  RunPointBench(suite , "perlin_turb" , points , [&perlin](const Point3& p) {
+    return perlin.Turb(p , 7);
+  });
+
+  if (suite.Enabled("image_texture_value")) {
+    ImageTexture earth("images/earthmap.jpg");
+    RunPointBench(suite , "image_texture_value" , points , [&earth](const Point3& p) {
+      return double(earth.Value(p.x / 16.0 , p.y / 16.0 , p).x);
+    });
+  }
+
+  /// pdfs , the hittable ones sample a sphere and a quad light seen from the origin
+  std::vector<glm::vec3> dirs = MakeDirections();
+
+  SpherePdf sphere_pdf;
+  RunPdfBench(suite , "sphere_pdf" , sphere_pdf , dirs);
+
+  CosinePdf cosine_pdf(glm::vec3(0 , 1 , 0));
+  RunPdfBench(suite , "cosine_pdf" , cosine_pdf , dirs);
+
+  Sphere sphere_light(Point3(0 , 4 , 0) , 1.0 , mat);
+  HittablePdf sphere_light_pdf(sphere_light , Point3(0 , 0 , 0) , 0.0);
+  RunPdfBench(suite , "hittable_pdf_sphere" , sphere_light_pdf , dirs);
+
+  Quad quad_light(Point3(-1 , 4 , -1) , glm::vec3(2 , 0 , 0) , glm::vec3(0 , 0 , 2) , mat);
+  HittablePdf quad_light_pdf(quad_light , Point3(0 , 0 , 0) , 0.0);
+  RunPdfBench(suite , "hittable_pdf_quad" , quad_light_pdf , dirs);
+
+  MixturePdf mixture_pdf(&quad_light_pdf , &cosine_pdf);
+  RunPdfBench(suite , "mixture_pdf" , mixture_pdf , dirs);
+}
@@ -0,0 +1,156 @@
+/**
+ * \file scene_bench.cpp
+ **/
+#include "bench.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+#include "compiled_scene.hpp"
+#include "scene_loader.hpp"
+
+/// reference scenes ported from raytracing.hpp
+static const char* bench_scenes[] = {
+  "bouncing_spheres" ,
+  "checkered_spheres" ,
+  "earth" ,
+  "perlin_spheres" ,
+  "quads" ,
+  "simple_light" ,
+  "cornell_box" ,
+  "cornell_smoke" ,
+  "final_scene" ,
+  "stratification" ,
+};
+
+/// forwards to the world and counts closest hit queries , camera rays , bounces and shadow
+///   rays alike. each thread bumps its own cache line so counting doesn't serialize workers
+class RayCounter : public Hittable {
+  public:
+    RayCounter(const Hittable& world)
+      : world(world) , id(next_id.fetch_add(1) + 1) {}
+
+    virtual bool Hit(const Ray& r , Interval rayt , HitRecord& rec) const override {
+      std::atomic<uint64_t>& count = LocalSlot().count;
+      count.store(count.load(std::memory_order_relaxed) + 1 , std::memory_order_relaxed);
+      return world.Hit(r , rayt , rec);
+    }
+
+    virtual Aabb BoundingBox() const override {
+      return world.BoundingBox();
+    }
+
+    virtual double PdfValue(const Point3& origin , const glm::vec3& direction , double time) const override {
+      return world.PdfValue(origin , direction , time);
+    }
+
+    virtual glm::vec3 Random(const Point3& origin , double time) const override {
+      return world.Random(origin , time);
+    }
+
+    virtual void CollectLights(LightCollector& collector) const override {
+      world.CollectLights(collector);
+    }
+
+    uint64_t Total() const {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      uint64_t total = 0;
+      for (const auto& slot : slots) {
+        total += slot->count.load(std::memory_order_relaxed);
+      }
+      return total;
+    }
+
+  private:
+    struct alignas(64) Slot {
+      std::atomic<uint64_t> count{ 0 };
+    };
+
+    /// counters of later scenes can reuse the address of an earlier one , threads tell
+    ///   them apart by id
+    static inline std::atomic<uint64_t> next_id{ 0 };
+
+    const Hittable& world;
+    uint64_t id;
+
+    mutable std::mutex mutex;
+    mutable std::vector<std::unique_ptr<Slot>> slots{};
+
+    Slot& LocalSlot() const {
+      thread_local uint64_t owner = 0;
+      thread_local Slot* slot = nullptr;
+      if (owner != id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        slots.push_back(std::make_unique<Slot>());
+        slot = slots.back().get();
+        owner = id;
+      }
+      return *slot;
+    }
+};
+
+void RunSceneBenchmarks(BenchSuite& suite , const SceneBenchOptions& options) {
+  for (const char* name : bench_scenes) {
+    std::string bench_name = std::string("scene_") + name;
+    if (!suite.Enabled(bench_name)) {
+      continue;
+    }
+
+    /// the camera reports every stage , only the numbers below are wanted here
+    std::ostringstream log;
+    std::streambuf* cout_buffer = std::cout.rdbuf(log.rdbuf());
+
+    /// perlin tables and anything else drawn while loading come from the calling thread
+    ThreadRng() = Rng();
+
+    SceneDescription scene;
+    bool loaded = LoadScene(options.scene_dir + "/" + name + ".scene" , scene);
+
+    double seconds = 0.0;
+    uint64_t rays = 0;
+    if (loaded) {
+      Camera& cam = scene.camera;
+      cam.img_width = options.img_width;
+      cam.samples_per_pixel = options.samples_per_pixel;
+      cam.num_threads = options.num_threads;
+      cam.seed = options.seed;
+      cam.img_file = std::string("bench_") + name + ".ppm";
+
+      /// the world is compiled already , the counter in front of it must not be compiled again
+      cam.compile_world = false;
+
+      RayCounter counter(*scene.compiled);
+
+      std::chrono::time_point<std::chrono::steady_clock> before = std::chrono::steady_clock::now();
+      if (scene.lights != nullptr) {
+        cam.Render(counter , scene.lights);
+      } else {
+        cam.Render(counter);
+      }
+      std::chrono::time_point<std::chrono::steady_clock> after = std::chrono::steady_clock::now();
+
+      seconds = std::chrono::duration<double>(after - before).count();
+      rays = counter.Total();
+    }
+
+    std::cout.rdbuf(cout_buffer);
+
+    if (!loaded) {
+      continue;
+    }
+
+    /// samples_per_pixel is rounded down to a square grid by the camera
+    uint64_t sqrt_spp = uint64_t(glm::sqrt(double(options.samples_per_pixel)));
+    uint64_t img_height = glm::max(uint64_t(options.img_width / scene.camera.aspect_ratio) , uint64_t(1));
+    uint64_t samples = uint64_t(options.img_width) * img_height * sqrt_spp * sqrt_spp;
+
+    BenchResult result = BenchSuite::MakeResult(bench_name , "scene" , samples , { seconds * 1e9 / double(samples) });
+    result.metrics.push_back({ "rays" , double(rays) });
+    result.metrics.push_back({ "mrays_per_sec" , seconds > 0.0 ? double(rays) / seconds * 1e-6 : 0.0 });
+    result.metrics.push_back({ "samples_per_sec" , seconds > 0.0 ? double(samples) / seconds : 0.0 });
+    suite.AddResult(result);
+  }
+}
@@ -5,7 +5,24 @@
 
 #include <iostream>
 
-int main() {
+int main(int argc , char* argv[]) {
+  /// scene files given on the command line are rendered in order , see scenes/. each one
+  ///   keeps its built bvhs in a .cache file next to it for the next run
+  if (argc > 1) {
+    int result = 0;
+    for (int i = 1; i < argc; ++i) {
+      SceneDescription scene;
+      if (!LoadScene(argv[i] , scene , std::string(argv[i]) + ".cache")) {
+        result = 1;
+        continue;
+      }
+
+      scene.Render();
+    }
+
+    return result;
+  }
+
   uint32_t example = 6;
 
   switch (example) {
@@ -25,4 +42,3 @@ int main() {
 
   return 0;
 }
-
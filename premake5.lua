@@ -16,6 +16,7 @@ configuration.platforms = { "Windows" }
 configuration.groups = {
   ["raytracer"] = { "./raytracer" } ,
   ["examples"] = { "./examples" } ,
+  ["bench"] = { "./bench" } ,
 }
 
 local glad = {}
@@ -1,3 +1,8 @@
+newoption {
+  trigger = "rt-stats" ,
+  description = "Build the raytracer with per render traversal and shading statistics (RT_ENABLE_STATS)"
+}
+
 local raytracer = {}
 raytracer.name = "raytracer"
 raytracer.path = "./raytracer"
@@ -16,6 +21,13 @@ raytracer.include_dirs = function()
   includedirs { "./src/" }
 end
 
+raytracer.defines = function()
+  defines { "SPDLOG_COMPILED_LIB" }
+  if _OPTIONS["rt-stats"] then
+    defines { "RT_ENABLE_STATS" }
+  end
+end
+
 raytracer.windows_configurations = function()
   files {}
   includedirs {}
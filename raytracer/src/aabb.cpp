@@ -3,8 +3,12 @@
  **/
 #include "aabb.hpp"
 
-const Aabb Aabb::empty = Aabb(Interval::empty , Interval::empty , Interval::empty);
-const Aabb Aabb::universe = Aabb(Interval::universe , Interval::universe , Interval::universe);
+#include "simd.hpp"
+
+/// built from literals rather than Interval::empty/universe , those live in another
+///   translation unit and may not be initialized yet when these are
+const Aabb Aabb::empty = Aabb(Interval(+infinity , -infinity) , Interval(+infinity , -infinity) , Interval(+infinity , -infinity));
+const Aabb Aabb::universe = Aabb(Interval(-infinity , +infinity) , Interval(-infinity , +infinity) , Interval(-infinity , +infinity));
     
 Aabb::Aabb(const Interval& x , const Interval& y , const Interval& z) 
     : x(x) , y(y) , z(z) {
@@ -35,47 +39,95 @@ const Interval& Aabb::AxisInterval(uint32_t n) const {
 }
 
 bool Aabb::Hit(const Ray& r , Interval ray_t) const {
-  const Point3& ray_origin = r.Origin();
-  const glm::vec3& ray_dir = r.Direction();
-
-  for (uint32_t axis = 0; axis < 3; ++axis) {
-    const Interval& ax = AxisInterval(axis);
-    double axis_val;
-    double orig_val;
-    switch (axis) {
-      case 0: 
-        axis_val = ray_dir.x; 
-        orig_val = ray_origin.x;
-        break;
-      case 1: 
-        axis_val = ray_dir.y; 
-        orig_val = ray_origin.y;
-        break;
-      case 2: 
-        axis_val = ray_dir.z; 
-        orig_val = ray_origin.z;
-        break;
-      default:
-        throw std::runtime_error("UNREACHABLE CODE | INVALID AXIS INDEX IN AABB::HIT");
-    }
-    const double adinv = 1.0 / axis_val;
-
-    auto t0 = (ax.min - orig_val) * adinv;
-    auto t1 = (ax.max - orig_val) * adinv;
-
-    if (t0 < t1) {
-      if (t0 > ray_t.min) ray_t.min = t0;
-      if (t1 < ray_t.max) ray_t.max = t1;
-    } else {
-      if (t1 > ray_t.min) ray_t.min = t1;
-      if (t0 < ray_t.max) ray_t.max = t0;
-    }
-
-    if (ray_t.max <= ray_t.min)
-      return false;
-  }
+  const Point3& origin = r.Origin();
+  const glm::vec3& inv_dir = r.InvDirection();
+
+#if defined(RT_SIMD_AVX)
+  /// lane 3 is an infinite slab so it never narrows the interval. origin and inv_dir are
+  ///   widened to double in one conversion each , the slab distances come out bit for bit
+  ///   the same as the scalar path
+  const __m256d lo = _mm256_set_pd(-infinity , z.min , y.min , x.min);
+  const __m256d hi = _mm256_set_pd(infinity , z.max , y.max , x.max);
+  const __m256d org = _mm256_cvtps_pd(_mm_set_ps(0.0f , origin.z , origin.y , origin.x));
+  const __m256d inv = _mm256_cvtps_pd(_mm_set_ps(1.0f , inv_dir.z , inv_dir.y , inv_dir.x));
+
+  __m256d t0 = _mm256_mul_pd(_mm256_sub_pd(lo , org) , inv);
+  __m256d t1 = _mm256_mul_pd(_mm256_sub_pd(hi , org) , inv);
+
+  /// blendv picks by the sign bit of inv , so negative directions swap near and far
+  __m256d t_near = _mm256_blendv_pd(t0 , t1 , inv);
+  __m256d t_far = _mm256_blendv_pd(t1 , t0 , inv);
+
+  /// NaN slab distances lose against the running interval , see IntersectNode
+  t_near = _mm256_max_pd(t_near , _mm256_set1_pd(ray_t.min));
+  t_far = _mm256_min_pd(t_far , _mm256_set1_pd(ray_t.max));
+
+  __m128d n = _mm_max_pd(_mm256_castpd256_pd128(t_near) , _mm256_extractf128_pd(t_near , 1));
+  __m128d f = _mm_min_pd(_mm256_castpd256_pd128(t_far) , _mm256_extractf128_pd(t_far , 1));
+  n = _mm_max_sd(n , _mm_unpackhi_pd(n , n));
+  f = _mm_min_sd(f , _mm_unpackhi_pd(f , f));
+
+  return _mm_cvtsd_f64(n) < _mm_cvtsd_f64(f);
+#elif defined(RT_SIMD_SSE)
+  /// x and y in one register of two doubles , z alone in the low lane of another whose
+  ///   high lane is an infinite slab. the intervals are stored min , max so the bounds of
+  ///   two axes come together with one unpack
+  const __m128d x_bounds = _mm_loadu_pd(&x.min);
+  const __m128d y_bounds = _mm_loadu_pd(&y.min);
+  const __m128d lo_xy = _mm_unpacklo_pd(x_bounds , y_bounds);
+  const __m128d hi_xy = _mm_unpackhi_pd(x_bounds , y_bounds);
+  const __m128d lo_z = _mm_set_pd(-infinity , z.min);
+  const __m128d hi_z = _mm_set_pd(infinity , z.max);
+
+  const __m128d org_xy = _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&origin.x))));
+  const __m128d inv_xy = _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&inv_dir.x))));
+  const __m128d org_z = _mm_set_pd(0.0 , origin.z);
+  const __m128d inv_z = _mm_set_pd(1.0 , inv_dir.z);
+
+  __m128d t0_xy = _mm_mul_pd(_mm_sub_pd(lo_xy , org_xy) , inv_xy);
+  __m128d t1_xy = _mm_mul_pd(_mm_sub_pd(hi_xy , org_xy) , inv_xy);
+  __m128d t0_z = _mm_mul_pd(_mm_sub_pd(lo_z , org_z) , inv_z);
+  __m128d t1_z = _mm_mul_pd(_mm_sub_pd(hi_z , org_z) , inv_z);
+
+  /// no blendv before SSE4.1 , the sign mask of inv swaps near and far instead
+  const __m128d neg_xy = _mm_cmplt_pd(inv_xy , _mm_setzero_pd());
+  const __m128d neg_z = _mm_cmplt_pd(inv_z , _mm_setzero_pd());
+  __m128d near_xy = _mm_or_pd(_mm_and_pd(neg_xy , t1_xy) , _mm_andnot_pd(neg_xy , t0_xy));
+  __m128d far_xy = _mm_or_pd(_mm_and_pd(neg_xy , t0_xy) , _mm_andnot_pd(neg_xy , t1_xy));
+  __m128d near_z = _mm_or_pd(_mm_and_pd(neg_z , t1_z) , _mm_andnot_pd(neg_z , t0_z));
+  __m128d far_z = _mm_or_pd(_mm_and_pd(neg_z , t0_z) , _mm_andnot_pd(neg_z , t1_z));
+
+  /// max and min return their second operand on NaN , so NaN slab distances leave the
+  ///   running interval as is
+  __m128d n = _mm_max_pd(near_xy , _mm_set1_pd(ray_t.min));
+  __m128d f = _mm_min_pd(far_xy , _mm_set1_pd(ray_t.max));
+  n = _mm_max_pd(near_z , n);
+  f = _mm_min_pd(far_z , f);
+  n = _mm_max_sd(n , _mm_unpackhi_pd(n , n));
+  f = _mm_min_sd(f , _mm_unpackhi_pd(f , f));
 
-  return true;
+  return _mm_cvtsd_f64(n) < _mm_cvtsd_f64(f);
+#else
+  const glm::uvec3& dir_is_neg = r.DirIsNeg();
+
+  auto slab = [&ray_t](const Interval& ax , double o , double inv , uint32_t neg) {
+    double t_near = ((neg ? ax.max : ax.min) - o) * inv;
+    double t_far = ((neg ? ax.min : ax.max) - o) * inv;
+
+    /// 0 * inf gives NaN when the origin sits on a slab plane of a zero direction
+    ///   component , the comparisons fail and the interval is left as is
+    ray_t.min = t_near > ray_t.min ? 
+      t_near : ray_t.min;
+    ray_t.max = t_far < ray_t.max ?
+      t_far : ray_t.max;
+  };
+
+  slab(x , origin.x , inv_dir.x , dir_is_neg.x);
+  slab(y , origin.y , inv_dir.y , dir_is_neg.y);
+  slab(z , origin.z , inv_dir.z , dir_is_neg.z);
+
+  return ray_t.min < ray_t.max;
+#endif // RT_SIMD_AVX
 }
 
 uint32_t Aabb::LongestAxis() const {
@@ -88,6 +140,22 @@ uint32_t Aabb::LongestAxis() const {
   }
 }
 
+double Aabb::SurfaceArea() const {
+  double dx = x.Size();
+  double dy = y.Size();
+  double dz = z.Size();
+
+  if (dx < 0 || dy < 0 || dz < 0) {
+    return 0.0;
+  }
+
+  return 2.0 * (dx * dy + dy * dz + dz * dx);
+}
+
+Point3 Aabb::Centroid() const {
+  return Point3(0.5 * (x.min + x.max) , 0.5 * (y.min + y.max) , 0.5 * (z.min + z.max));
+}
+
 void Aabb::PadToMinimums() {
   double delta = 0.0001;
   if (x.Size() < delta) x = x.Expand(delta);
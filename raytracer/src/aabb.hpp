@@ -23,6 +23,10 @@ class Aabb {
 
     uint32_t LongestAxis() const;
 
+    double SurfaceArea() const;
+
+    Point3 Centroid() const;
+
     static const Aabb empty , universe;
 
   private:
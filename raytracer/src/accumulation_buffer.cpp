@@ -0,0 +1,182 @@
+/**
+ * \file accumulation_buffer.cpp
+ **/
+#include "accumulation_buffer.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#include "mapped_file.hpp"
+
+/// "RTCK" read as little endian
+static constexpr uint32_t checkpoint_magic = 0x4b435452;
+static constexpr uint32_t checkpoint_version = 2;
+
+struct CheckpointHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t width;
+  uint32_t height;
+  uint64_t seed;
+  uint32_t pass_size;
+  uint32_t flags;
+  uint64_t settings;
+};
+
+/// the luminance mean and m2 of every pixel follow the samples
+static constexpr uint32_t checkpoint_has_variance = 1;
+
+void AccumulationBuffer::Reset(uint32_t width , uint32_t height , bool track_variance) {
+  this->width = width;
+  this->height = height;
+
+  radiance.assign(size_t(width) * height , Color(0 , 0 , 0));
+  samples.assign(size_t(width) * height , 0);
+
+  if (track_variance) {
+    luminance_mean.assign(size_t(width) * height , 0.0);
+    luminance_m2.assign(size_t(width) * height , 0.0);
+  } else {
+    luminance_mean.clear();
+    luminance_mean.shrink_to_fit();
+    luminance_m2.clear();
+    luminance_m2.shrink_to_fit();
+  }
+}
+
+void AccumulationBuffer::Add(size_t pixel , const Color& radiance_sum , uint32_t num_samples) {
+  radiance[pixel] += radiance_sum;
+  samples[pixel] += num_samples;
+}
+
+void AccumulationBuffer::AddSample(size_t pixel , const Color& sample) {
+  radiance[pixel] += sample;
+  uint32_t n = ++samples[pixel];
+
+  if (luminance_mean.empty()) {
+    return;
+  }
+
+  /// samples that came out NaN are kept out of the estimate like the writers keep them out
+  ///   of the image
+  double luminance = 0.2126 * sample.x + 0.7152 * sample.y + 0.0722 * sample.z;
+  if (luminance != luminance) {
+    luminance = 0.0;
+  }
+
+  double delta = luminance - luminance_mean[pixel];
+  luminance_mean[pixel] += delta / n;
+  luminance_m2[pixel] += delta * (luminance - luminance_mean[pixel]);
+}
+
+double AccumulationBuffer::DisplayError(size_t pixel) const {
+  uint32_t n = samples[pixel];
+  if (luminance_mean.empty() || n < 2) {
+    return infinity;
+  }
+
+  double mean = glm::max(luminance_mean[pixel] , 0.0);
+  double std_error = glm::sqrt(luminance_m2[pixel] / (double(n - 1) * n));
+
+  return glm::sqrt(glm::min(mean + std_error , 1.0)) - glm::sqrt(glm::min(mean , 1.0));
+}
+
+double AccumulationBuffer::RmsDisplayError() const {
+  double sum = 0.0;
+  for (size_t p = 0; p < samples.size(); ++p) {
+    double error = DisplayError(p);
+    sum += error * error;
+  }
+
+  return samples.empty() ?
+    0.0 : glm::sqrt(sum / double(samples.size()));
+}
+
+Color AccumulationBuffer::Average(size_t pixel) const {
+  if (samples[pixel] == 0) {
+    return Color(0 , 0 , 0);
+  }
+
+  return (1.0 / samples[pixel]) * radiance[pixel];
+}
+
+uint32_t AccumulationBuffer::SampleCount(size_t pixel) const {
+  return samples[pixel];
+}
+
+uint32_t AccumulationBuffer::Width() const {
+  return width;
+}
+
+uint32_t AccumulationBuffer::Height() const {
+  return height;
+}
+
+bool AccumulationBuffer::Save(const std::string& file_name , uint64_t seed , uint32_t pass_size , uint64_t settings) const {
+  uint32_t flags = luminance_mean.empty() ?
+    0 : checkpoint_has_variance;
+  CheckpointHeader header = { checkpoint_magic , checkpoint_version , width , height , seed , pass_size , flags , settings };
+
+  /// the variance arrays are empty unless tracked
+  return WriteFileAtomic(file_name , {
+    { &header , sizeof(header) } ,
+    { radiance.data() , radiance.size() * sizeof(Color) } ,
+    { samples.data() , samples.size() * sizeof(uint32_t) } ,
+    { luminance_mean.data() , luminance_mean.size() * sizeof(double) } ,
+    { luminance_m2.data() , luminance_m2.size() * sizeof(double) } ,
+  } , "checkpoint file");
+}
+
+bool AccumulationBuffer::Load(const std::string& file_name , uint64_t seed , uint32_t pass_size , uint64_t settings) {
+  MappedFile file;
+  if (!file.Open(file_name) || file.Size() < sizeof(CheckpointHeader)) {
+    return false;
+  }
+
+  CheckpointHeader header;
+  std::memcpy(&header , file.Data() , sizeof(header));
+
+  if (header.magic != checkpoint_magic || header.version != checkpoint_version) {
+    std::cerr << "ERROR : Not a checkpoint file : " << file_name << "\n";
+    return false;
+  }
+
+  if (header.width != width || header.height != height || header.seed != seed || header.pass_size != pass_size) {
+    std::cerr << "ERROR : Checkpoint was saved with other render settings : " << file_name << "\n";
+    return false;
+  }
+
+  if (header.settings != settings) {
+    std::cerr << "ERROR : Checkpoint was saved for another scene , camera or integrator : " << file_name << "\n";
+    return false;
+  }
+
+  bool has_variance = (header.flags & checkpoint_has_variance) != 0;
+  if (!luminance_mean.empty() && !has_variance) {
+    std::cerr << "ERROR : Checkpoint was saved without noise estimates : " << file_name << "\n";
+    return false;
+  }
+
+  size_t num_pixels = size_t(width) * height;
+  size_t radiance_bytes = num_pixels * sizeof(Color);
+  size_t sample_bytes = num_pixels * sizeof(uint32_t);
+  size_t variance_bytes = has_variance ?
+    2 * num_pixels * sizeof(double) : 0;
+  if (file.Size() != sizeof(header) + radiance_bytes + sample_bytes + variance_bytes) {
+    std::cerr << "ERROR : Checkpoint file is truncated : " << file_name << "\n";
+    return false;
+  }
+
+  const uint8_t* data = file.Data() + sizeof(header);
+  std::memcpy(radiance.data() , data , radiance_bytes);
+  std::memcpy(samples.data() , data + radiance_bytes , sample_bytes);
+
+  /// a buffer that doesn't track variance just ignores it
+  if (!luminance_mean.empty()) {
+    const uint8_t* variance = data + radiance_bytes + sample_bytes;
+    std::memcpy(luminance_mean.data() , variance , num_pixels * sizeof(double));
+    std::memcpy(luminance_m2.data() , variance + num_pixels * sizeof(double) , num_pixels * sizeof(double));
+  }
+
+  return true;
+}
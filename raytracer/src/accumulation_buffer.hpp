@@ -0,0 +1,70 @@
+/**
+ * \file accumulation_buffer.hpp
+ **/
+#ifndef ACCUMULATION_BUFFER_HPP
+#define ACCUMULATION_BUFFER_HPP
+
+#include <string>
+#include <vector>
+
+#include "defines.hpp"
+
+/// running per pixel sums of radiance and the number of samples behind them. sample n of a
+///   pixel always draws from the rng stream (seed , pixel , n) so the counts are also the
+///   stream positions , saving them is enough for a resumed render to carry on where the
+///   saved one stopped
+class AccumulationBuffer {
+  public:
+    AccumulationBuffer() {}
+
+    /// resizes to width x height and clears every pixel. with track_variance AddSample also
+    ///   keeps the running mean and variance of the luminance of every pixel
+    void Reset(uint32_t width , uint32_t height , bool track_variance = false);
+
+    /// adds samples whose radiance sums to radiance_sum , one writer per pixel at a time
+    void Add(size_t pixel , const Color& radiance_sum , uint32_t samples);
+
+    /// adds a single sample and folds its luminance into the variance with Welford's update
+    ///   when tracked , same writer rule as Add
+    void AddSample(size_t pixel , const Color& sample);
+
+    /// standard error of the mean luminance as displayed , i.e. after the sqrt gamma of the 8 bit
+    ///   writers where 1/255 is one step. 0 where mean and error clip to white anyway , infinity
+    ///   for pixels with fewer than two tracked samples
+    double DisplayError(size_t pixel) const;
+
+    /// root mean square of DisplayError over every pixel
+    double RmsDisplayError() const;
+
+    /// black for pixels without samples
+    Color Average(size_t pixel) const;
+
+    uint32_t SampleCount(size_t pixel) const;
+
+    uint32_t Width() const;
+    uint32_t Height() const;
+
+    /// binary checkpoint through WriteFileAtomic. seed , pass_size and settings , a hash of
+    ///   the scene and everything else the samples depend on , are stored to reject resuming
+    ///   a render that would draw different samples. the variance goes with the sums when
+    ///   tracked
+    bool Save(const std::string& file_name , uint64_t seed , uint32_t pass_size , uint64_t settings) const;
+
+    /// the buffer has to be Reset to the image size first. false and unchanged when
+    ///   file_name is missing , damaged , saved for another image size , seed , pass size or
+    ///   settings or without the variance this buffer tracks
+    bool Load(const std::string& file_name , uint64_t seed , uint32_t pass_size , uint64_t settings);
+
+  private:
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    std::vector<Color> radiance{};
+    std::vector<uint32_t> samples{};
+
+    /// empty unless tracking variance
+    std::vector<double> luminance_mean{};
+    std::vector<double> luminance_m2{};
+};
+
+#endif // !ACCUMULATION_BUFFER_HPP
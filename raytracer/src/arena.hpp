@@ -0,0 +1,82 @@
+/**
+ * \file arena.hpp
+ **/
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+/// bump allocator for short lived objects on the render path. memory is handed out
+///   linearly from fixed size blocks and reclaimed all at once by Reset , blocks are kept
+///   so a warmed up arena never touches the heap again. destructors are never run , only
+///   place objects here that don't own resources
+class Arena {
+  public:
+    static constexpr size_t block_size = 64 * 1024;
+
+    Arena() {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /// nullptr only when size and alignment can't fit an empty block , a full block just
+    ///   moves on to the next one
+    void* Allocate(size_t size , size_t alignment) {
+      if (size + alignment > block_size) {
+        return nullptr;
+      }
+
+      while (true) {
+        if (current_block < blocks.size()) {
+          uintptr_t base = reinterpret_cast<uintptr_t>(blocks[current_block].get());
+          uintptr_t aligned = (base + offset + alignment - 1) & ~uintptr_t(alignment - 1);
+
+          if (aligned + size <= base + block_size) {
+            offset = size_t(aligned + size - base);
+            return reinterpret_cast<void*>(aligned);
+          }
+
+          ++current_block;
+          offset = 0;
+          continue;
+        }
+
+        blocks.push_back(std::make_unique<std::byte[]>(block_size));
+      }
+    }
+
+    /// never null , a type that couldn't fit a block is rejected at compile time
+    template <typename T , typename... Args>
+    T* New(Args&&... args) {
+      static_assert(sizeof(T) + alignof(T) <= block_size , "type too large for an arena block");
+      return new (Allocate(sizeof(T) , alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /// releases everything allocated since the last reset
+    void Reset() {
+      current_block = 0;
+      offset = 0;
+    }
+
+    size_t NumBlocks() const {
+      return blocks.size();
+    }
+
+  private:
+    std::vector<std::unique_ptr<std::byte[]>> blocks{};
+    size_t current_block = 0;
+    size_t offset = 0;
+};
+
+/// per thread arena , the camera resets it before every sample
+inline Arena& ThreadArena() {
+  thread_local Arena arena;
+  return arena;
+}
+
+#endif // !ARENA_HPP
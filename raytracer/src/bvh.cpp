@@ -4,6 +4,10 @@
 #include "bvh.hpp"
 
 #include <algorithm>
+
+#include "compiled_scene.hpp"
+#include "light_sampler.hpp"
+#include "render_stats.hpp"
     
 BvhNode::BvhNode(std::vector<Ref<Hittable>>& objects , size_t start , size_t end) {
   bbox = Aabb::empty;
@@ -35,6 +39,8 @@ BvhNode::BvhNode(std::vector<Ref<Hittable>>& objects , size_t start , size_t end
 }
 
 bool BvhNode::Hit(const Ray& r , Interval rayt , HitRecord& rec) const {
+  RT_STATS(++ThreadStats().bvh_nodes_visited;)
+
   if (!bbox.Hit(r , rayt)) {
     return false;
   } 
@@ -49,20 +55,34 @@ Aabb BvhNode::BoundingBox() const {
   return bbox;
 }
     
-double BvhNode::PdfValue(const Point3& origin , const glm::vec3& direction) const {
+double BvhNode::PdfValue(const Point3& origin , const glm::vec3& direction , double time) const {
   auto weight = 1.0 / 2.0;
   auto sum = 0.0;
   
-  sum += weight * left->PdfValue(origin , direction);
-  sum += weight * right->PdfValue(origin , direction);
+  sum += weight * left->PdfValue(origin , direction , time);
+  sum += weight * right->PdfValue(origin , direction , time);
 
   return sum;
 } 
 
-glm::vec3 BvhNode::Random(const Point3& origin) const {
+glm::vec3 BvhNode::Random(const Point3& origin , double time) const {
   auto random = RandomInt();
   return random % 2 == 0 ?
-    left->Random(origin) : right->Random(origin);
+    left->Random(origin , time) : right->Random(origin , time);
+}
+
+void BvhNode::Compile(SceneCompiler& compiler) const {
+  left->Compile(compiler);
+  if (right != left) {
+    right->Compile(compiler);
+  }
+}
+
+void BvhNode::CollectLights(LightCollector& collector) const {
+  left->CollectLights(collector);
+  if (right != left) {
+    right->CollectLights(collector);
+  }
 }
 
 bool BvhNode::BoxCompare(const Ref<Hittable> a , const Ref<Hittable> b , int axis_index) {
@@ -0,0 +1,366 @@
+/**
+ * \file bvh_builder.cpp
+ **/
+#include "bvh_builder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <iostream>
+#include <thread>
+
+/// conservative double -> float conversions so float boxes always enclose the double ones
+static float RoundDown(double v) {
+  float f = float(v);
+  return (double(f) > v) ? 
+    std::nextafter(f , -std::numeric_limits<float>::infinity()) : f;
+}
+
+static float RoundUp(double v) {
+  float f = float(v);
+  return (double(f) < v) ?
+    std::nextafter(f , std::numeric_limits<float>::infinity()) : f;
+}
+
+static constexpr uint32_t max_sah_depth = 40;
+static constexpr uint32_t max_bins = 64;
+
+/// levels of median splits it takes to bring count primitives down to leaves of leaf_size
+static uint32_t MedianLevels(uint32_t count , uint32_t leaf_size) {
+  uint32_t levels = 0;
+  while (count > leaf_size) {
+    count = count - count / 2;
+    ++levels;
+  }
+  return levels;
+}
+
+static double NodeSurfaceArea(const LinearBvhNode& node) {
+  double dx = double(node.bounds[1][0]) - node.bounds[0][0];
+  double dy = double(node.bounds[1][1]) - node.bounds[0][1];
+  double dz = double(node.bounds[1][2]) - node.bounds[0][2];
+  return 2.0 * (dx * dy + dy * dz + dz * dx);
+}
+
+void BvhBuilder::Bounds::Grow(const Bounds& other) {
+  min = glm::min(min , other.min);
+  max = glm::max(max , other.max);
+}
+
+void BvhBuilder::Bounds::Grow(const glm::dvec3& p) {
+  min = glm::min(min , p);
+  max = glm::max(max , p);
+}
+
+double BvhBuilder::Bounds::SurfaceArea() const {
+  glm::dvec3 d = max - min;
+  if (d.x < 0 || d.y < 0 || d.z < 0) {
+    return 0.0;
+  }
+  return 2.0 * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+uint32_t BvhBuilder::Bounds::LongestAxis() const {
+  glm::dvec3 d = max - min;
+  if (d.x > d.y) {
+    return d.x > d.z ? 
+      0 : 2;
+  } else {
+    return d.y > d.z ?
+      1 : 2;
+  }
+}
+
+void BvhBuildStats::Print(const std::string& label) const {
+  std::cout << "BVH [" << label << "] : " << num_prims << " prims , " 
+            << num_nodes << " nodes , " << num_leaves << " leaves , max depth " << max_depth << "\n";
+  std::cout << "  SAH cost : [" << sah_cost << "] , build time : [" << build_ms << "]ms\n";
+  std::cout << "  leaf sizes :";
+  for (size_t n = 1; n < leaf_histogram.size(); ++n) {
+    if (leaf_histogram[n] > 0) {
+      std::cout << " " << n << "x" << leaf_histogram[n];
+    }
+  }
+  std::cout << "\n";
+}
+
+BvhBuilder::BvhBuilder(const std::vector<Aabb>& prim_bounds , const BvhBuildOptions& options)
+    : prim_bounds(prim_bounds) , options(options) {
+  this->options.max_leaf_size = std::clamp(options.max_leaf_size , 1u , uint32_t(std::numeric_limits<uint16_t>::max()));
+  this->options.num_bins = std::clamp(options.num_bins , 2u , max_bins);
+}
+
+FlatBvh BvhBuilder::Build() {
+  std::chrono::time_point<std::chrono::steady_clock> before = std::chrono::steady_clock::now();
+
+  FlatBvh bvh;
+  if (prim_bounds.empty()) {
+    return bvh;
+  }
+
+  indices.resize(prim_bounds.size());
+  boxes.resize(prim_bounds.size());
+  centroids.resize(prim_bounds.size());
+  for (uint32_t i = 0; i < indices.size(); ++i) {
+    indices[i] = i;
+
+    const Aabb& b = prim_bounds[i];
+    boxes[i].min = glm::dvec3(b.x.min , b.y.min , b.z.min);
+    boxes[i].max = glm::dvec3(b.x.max , b.y.max , b.z.max);
+    centroids[i] = 0.5 * (boxes[i].min + boxes[i].max);
+  }
+
+  /// enough levels to give every hardware thread a subtree
+  uint32_t hw_threads = std::max(std::thread::hardware_concurrency() , 1u);
+  max_parallel_depth = 1;
+  while ((1u << max_parallel_depth) < hw_threads) {
+    ++max_parallel_depth;
+  }
+
+  std::unique_ptr<BuildNode> root = BuildRecursive(0 , uint32_t(indices.size()) , 0);
+
+  bvh.nodes.reserve(CountNodes(root.get()));
+  Flatten(root.get() , bvh.nodes);
+  bvh.prim_indices = std::move(indices);
+
+  boxes.clear();
+  centroids.clear();
+
+  std::chrono::time_point<std::chrono::steady_clock> after = std::chrono::steady_clock::now();
+
+  bvh.stats = ComputeStats(bvh , options);
+  bvh.stats.build_ms = std::chrono::duration<double , std::milli>(after - before).count();
+
+  return bvh;
+}
+
+std::unique_ptr<BvhBuilder::BuildNode> BvhBuilder::BuildRecursive(uint32_t start , uint32_t end , uint32_t depth) {
+  auto node = std::make_unique<BuildNode>();
+  for (uint32_t i = start; i < end; ++i) {
+    node->bbox.Grow(boxes[indices[i]]);
+  }
+
+  node->first = start;
+  node->count = end - start;
+  node->axis = node->bbox.LongestAxis();
+
+  /// SAH splits can be arbitrarily lopsided , deep chains and any node whose children could
+  ///   no longer finish with median splits within max_depth fall back to median splits. a
+  ///   median split always halves the range so the tree never gets deeper than max_depth
+  bool use_sah = options.split_method == BvhSplitMethod::SAH && depth < max_sah_depth &&
+    depth + MedianLevels(node->count , options.max_leaf_size) < max_depth;
+  uint32_t mid = use_sah ?
+    SplitSah(*node , start , end) : SplitMedian(*node , start , end);
+
+  if (mid == start) {
+    return node;
+  }
+
+  /// the two halves own disjoint index ranges so big ones can be built concurrently
+  if (node->count >= options.parallel_threshold && depth < max_parallel_depth) {
+    auto left = std::async(std::launch::async , [this , start , mid , depth]() {
+      return BuildRecursive(start , mid , depth + 1);
+    });
+    node->children[1] = BuildRecursive(mid , end , depth + 1);
+    node->children[0] = left.get();
+  } else {
+    node->children[0] = BuildRecursive(start , mid , depth + 1);
+    node->children[1] = BuildRecursive(mid , end , depth + 1);
+  }
+
+  return node;
+}
+
+uint32_t BvhBuilder::SplitMedian(BuildNode& node , uint32_t start , uint32_t end) {
+  if (node.count <= options.max_leaf_size) {
+    return start;
+  }
+
+  uint32_t axis = node.axis;
+  std::sort(indices.begin() + start , indices.begin() + end , [this , axis](uint32_t a , uint32_t b) {
+    return boxes[a].min[axis] < boxes[b].min[axis];
+  });
+
+  return start + node.count / 2;
+}
+
+uint32_t BvhBuilder::SplitSah(BuildNode& node , uint32_t start , uint32_t end) {
+  if (node.count == 1) {
+    return start;
+  }
+
+  Bounds centroid_bounds;
+  for (uint32_t i = start; i < end; ++i) {
+    centroid_bounds.Grow(centroids[indices[i]]);
+  }
+  const glm::dvec3& cmin = centroid_bounds.min;
+  const glm::dvec3& cmax = centroid_bounds.max;
+
+  struct Bin {
+    Bounds bbox;
+    uint32_t count = 0;
+  };
+
+  const uint32_t num_bins = options.num_bins;
+  std::array<Bin , max_bins> bins;
+  std::array<double , max_bins> right_area;
+  std::array<uint32_t , max_bins> right_count;
+
+  double best_cost = infinity;
+  uint32_t best_axis = 0;
+  uint32_t best_split = 0;
+
+  for (uint32_t axis = 0; axis < 3; ++axis) {
+    double extent = cmax[axis] - cmin[axis];
+    if (extent <= 0.0) {
+      continue;
+    }
+
+    std::fill(bins.begin() , bins.begin() + num_bins , Bin());
+    double scale = num_bins / extent;
+    for (uint32_t i = start; i < end; ++i) {
+      uint32_t prim = indices[i];
+      uint32_t b = std::min(uint32_t((centroids[prim][axis] - cmin[axis]) * scale) , num_bins - 1);
+      bins[b].count++;
+      bins[b].bbox.Grow(boxes[prim]);
+    }
+
+    /// sweep from the right to get the area and count right of every split plane
+    Bounds acc;
+    uint32_t acc_count = 0;
+    for (uint32_t b = num_bins - 1; b > 0; --b) {
+      acc.Grow(bins[b].bbox);
+      acc_count += bins[b].count;
+      right_area[b] = acc.SurfaceArea();
+      right_count[b] = acc_count;
+    }
+
+    acc = Bounds();
+    acc_count = 0;
+    for (uint32_t b = 0; b < num_bins - 1; ++b) {
+      acc.Grow(bins[b].bbox);
+      acc_count += bins[b].count;
+      if (acc_count == 0 || right_count[b + 1] == 0) {
+        continue;
+      }
+
+      double cost = acc.SurfaceArea() * acc_count + right_area[b + 1] * right_count[b + 1];
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_split = b + 1;
+      }
+    }
+  }
+
+  double node_area = node.bbox.SurfaceArea();
+  double leaf_cost = options.intersection_cost * node.count;
+
+  /// all centroids coincide , no plane can separate them
+  if (best_cost == infinity) {
+    if (node.count <= options.max_leaf_size) {
+      return start;
+    }
+    return start + node.count / 2;
+  }
+
+  double split_cost = options.traversal_cost + 
+    (node_area > 0 ? options.intersection_cost * best_cost / node_area : options.intersection_cost * node.count);
+
+  if (node.count <= options.max_leaf_size && leaf_cost <= split_cost) {
+    return start;
+  }
+
+  double extent = cmax[best_axis] - cmin[best_axis];
+  double scale = num_bins / extent;
+  auto mid_it = std::partition(indices.begin() + start , indices.begin() + end , [&](uint32_t prim) {
+    uint32_t b = std::min(uint32_t((centroids[prim][best_axis] - cmin[best_axis]) * scale) , num_bins - 1);
+    return b < best_split;
+  });
+
+  uint32_t mid = uint32_t(mid_it - indices.begin());
+  if (mid == start || mid == end) {
+    mid = start + node.count / 2;
+  }
+
+  node.axis = best_axis;
+  return mid;
+}
+
+uint32_t BvhBuilder::CountNodes(const BuildNode* node) const {
+  if (node->children[0] == nullptr) {
+    return 1;
+  }
+
+  return 1 + CountNodes(node->children[0].get()) + CountNodes(node->children[1].get());
+}
+
+uint32_t BvhBuilder::Flatten(const BuildNode* node , std::vector<LinearBvhNode>& out) const {
+  uint32_t flat_idx = uint32_t(out.size());
+  out.emplace_back();
+
+  LinearBvhNode flat{};
+  for (uint32_t a = 0; a < 3; ++a) {
+    flat.bounds[0][a] = RoundDown(node->bbox.min[a]);
+    flat.bounds[1][a] = RoundUp(node->bbox.max[a]);
+  }
+  flat.axis = uint8_t(node->axis);
+
+  if (node->children[0] == nullptr) {
+    flat.offset = node->first;
+    flat.prim_count = uint16_t(node->count);
+  } else {
+    flat.prim_count = 0;
+    Flatten(node->children[0].get() , out);
+    flat.offset = Flatten(node->children[1].get() , out);
+  }
+
+  out[flat_idx] = flat;
+  return flat_idx;
+}
+
+BvhBuildStats BvhBuilder::ComputeStats(const FlatBvh& bvh , const BvhBuildOptions& options) {
+  BvhBuildStats stats;
+  stats.num_prims = uint32_t(bvh.prim_indices.size());
+  stats.num_nodes = uint32_t(bvh.nodes.size());
+
+  if (bvh.nodes.empty()) {
+    return stats;
+  }
+
+  double root_area = NodeSurfaceArea(bvh.nodes[0]);
+  if (root_area <= 0) {
+    root_area = 1.0;
+  }
+
+  std::vector<std::pair<uint32_t , uint32_t>> stack;
+  stack.emplace_back(0 , 0);
+
+  while (!stack.empty()) {
+    auto [idx , depth] = stack.back();
+    stack.pop_back();
+
+    const LinearBvhNode& node = bvh.nodes[idx];
+    double rel_area = NodeSurfaceArea(node) / root_area;
+
+    stats.max_depth = std::max(stats.max_depth , depth);
+
+    if (node.IsLeaf()) {
+      stats.num_leaves++;
+      stats.sah_cost += rel_area * options.intersection_cost * node.prim_count;
+
+      if (stats.leaf_histogram.size() <= node.prim_count) {
+        stats.leaf_histogram.resize(node.prim_count + 1 , 0);
+      }
+      stats.leaf_histogram[node.prim_count]++;
+    } else {
+      stats.sah_cost += rel_area * options.traversal_cost;
+      stack.emplace_back(idx + 1 , depth + 1);
+      stack.emplace_back(node.offset , depth + 1);
+    }
+  }
+
+  return stats;
+}
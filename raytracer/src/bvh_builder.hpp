@@ -0,0 +1,144 @@
+/**
+ * \file bvh_builder.hpp
+ **/
+#ifndef BVH_BUILDER_HPP
+#define BVH_BUILDER_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "defines.hpp"
+#include "aabb.hpp"
+
+/// 32 byte node of a flattened binary bvh. nodes are laid out depth first so the
+///   first child of an interior node is always the node directly after it
+struct LinearBvhNode {
+  /// [0] = min corner , [1] = max corner , rounded outwards to float
+  float bounds[2][3];
+
+  /// interior : index of the second child , leaf : index of the first primitive
+  uint32_t offset;
+
+  /// 0 for interior nodes
+  uint16_t prim_count;
+
+  /// split axis of interior nodes
+  uint8_t axis;
+  uint8_t pad;
+
+  bool IsLeaf() const {
+    return prim_count > 0;
+  }
+};
+
+static_assert(sizeof(LinearBvhNode) == 32 , "LinearBvhNode must stay 32 bytes");
+
+enum class BvhSplitMethod {
+  /// object median on the longest axis , the policy of BvhNode
+  MEDIAN ,
+  /// binned surface area heuristic over primitive centroids
+  SAH ,
+};
+
+class BvhBuildOptions {
+  public:
+    BvhSplitMethod split_method = BvhSplitMethod::SAH;
+
+    /// leaves hold at most this many primitives (MEDIAN always splits down to it)
+    uint32_t max_leaf_size = 4;
+
+    /// clamped to [2 , 64]
+    uint32_t num_bins = 16;
+
+    /// relative costs of one node visit and one primitive test used by the SAH
+    double traversal_cost = 1.0;
+    double intersection_cost = 1.0;
+
+    /// subtrees with at least this many primitives are built on their own thread
+    uint32_t parallel_threshold = 4096;
+};
+
+/// tree quality summary so builders can be compared against each other
+class BvhBuildStats {
+  public:
+    /// expected cost of a random ray under the SAH model , relative to the root area
+    double sah_cost = 0.0;
+
+    uint32_t num_prims = 0;
+    uint32_t num_nodes = 0;
+    uint32_t num_leaves = 0;
+    uint32_t max_depth = 0;
+
+    /// leaf_histogram[n] = number of leaves holding n primitives
+    std::vector<uint32_t> leaf_histogram{};
+
+    double build_ms = 0.0;
+
+    void Print(const std::string& label) const;
+};
+
+class FlatBvh {
+  public:
+    std::vector<LinearBvhNode> nodes{};
+
+    /// leaf primitive ranges index into this list of input primitive indices
+    std::vector<uint32_t> prim_indices{};
+
+    BvhBuildStats stats{};
+};
+
+/// builds a FlatBvh over a set of primitive bounds
+class BvhBuilder {
+  public:
+    /// no leaf is deeper than this , the root being depth 0. a traversal pushes at most one
+    ///   node per level so stacks of this size never overflow
+    static constexpr uint32_t max_depth = 64;
+
+    BvhBuilder(const std::vector<Aabb>& prim_bounds , const BvhBuildOptions& options = BvhBuildOptions());
+
+    FlatBvh Build();
+
+  private:
+    /// plain min/max box , much cheaper to grow than an Aabb of Intervals
+    struct Bounds {
+      glm::dvec3 min = glm::dvec3(infinity);
+      glm::dvec3 max = glm::dvec3(-infinity);
+
+      void Grow(const Bounds& other);
+      void Grow(const glm::dvec3& p);
+      double SurfaceArea() const;
+      uint32_t LongestAxis() const;
+    };
+
+    struct BuildNode {
+      Bounds bbox;
+      uint32_t first = 0;
+      uint32_t count = 0;
+      uint32_t axis = 0;
+      std::unique_ptr<BuildNode> children[2];
+    };
+
+    const std::vector<Aabb>& prim_bounds;
+    BvhBuildOptions options;
+
+    std::vector<Bounds> boxes{};
+    std::vector<glm::dvec3> centroids{};
+    std::vector<uint32_t> indices{};
+
+    uint32_t max_parallel_depth = 0;
+
+    std::unique_ptr<BuildNode> BuildRecursive(uint32_t start , uint32_t end , uint32_t depth);
+
+    /// returns the partition point , or start when the range should stay a leaf
+    uint32_t SplitMedian(BuildNode& node , uint32_t start , uint32_t end);
+    uint32_t SplitSah(BuildNode& node , uint32_t start , uint32_t end);
+
+    uint32_t CountNodes(const BuildNode* node) const;
+
+    uint32_t Flatten(const BuildNode* node , std::vector<LinearBvhNode>& out) const;
+
+    static BvhBuildStats ComputeStats(const FlatBvh& bvh , const BvhBuildOptions& options);
+};
+
+#endif // !BVH_BUILDER_HPP
@@ -3,115 +3,249 @@
  **/
 #include "camera.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <iostream>
-#include <fstream>
-#include <latch>
-#include <syncstream>
+#include <limits>
 
 #include "defines.hpp"
+#include "arena.hpp"
+#include "compiled_scene.hpp"
 #include "material.hpp"
 #include "pdf.hpp"
+#include "scene_cache.hpp"
+
+/// weight of a sample drawn with pdf f_pdf that another strategy could have drawn with g_pdf
+static double PowerHeuristic(double f_pdf , double g_pdf) {
+  double f2 = f_pdf * f_pdf;
+  double g2 = g_pdf * g_pdf;
+  return (f2 + g2 > 0.0) ?
+    f2 / (f2 + g2) : 0.0;
+}
+
+/// running total of the counter a heatmap of mode is built from , differences over a pixel
+///   give its cost
+static uint64_t HeatmapCounter([[maybe_unused]] OutputMode mode) {
+#ifdef RT_ENABLE_STATS
+  if (mode == OutputMode::BVH_NODES) {
+    return ThreadStats().bvh_nodes_visited;
+  }
 
-inline double LinearToGamma(double linear_component) {
-  if (linear_component > 0) {
-    return glm::sqrt(linear_component);
+  if (mode == OutputMode::PRIM_TESTS) {
+    return ThreadStats().NumPrimTests();
   }
+#endif // RT_ENABLE_STATS
 
   return 0;
 }
 
-inline void WriteColor(std::ostream& stream , const Color& color) {
-  auto r = color.x;
-  auto g = color.y;
-  auto b = color.z;
+/// samples of the turbo colormap at even steps , display values
+static const Color heatmap_ramp[] = {
+  Color(0.190 , 0.072 , 0.232) ,
+  Color(0.275 , 0.490 , 0.965) ,
+  Color(0.107 , 0.898 , 0.685) ,
+  Color(0.640 , 0.991 , 0.236) ,
+  Color(0.977 , 0.729 , 0.222) ,
+  Color(0.868 , 0.264 , 0.034) ,
+  Color(0.480 , 0.016 , 0.011) ,
+};
+
+/// t in [0 , 1] to linear rgb , the image writers gamma encode it back to the ramp
+static Color FalseColor(double t) {
+  constexpr uint32_t num_keys = sizeof(heatmap_ramp) / sizeof(heatmap_ramp[0]);
+
+  double x = glm::clamp(t , 0.0 , 1.0) * (num_keys - 1);
+  uint32_t key = glm::min(uint32_t(x) , num_keys - 2);
+  Color display = glm::mix(heatmap_ramp[key] , heatmap_ramp[key + 1] , float(x - key));
+
+  return display * display;
+}
 
-  if (r != r) {
-    r = 0.0;
-  }
+void Camera::Render(const Hittable& world) {
+  RT_STATS(ResetThreadStats();)
 
-  if (g != g) {
-    g = 0.0;
-  }
+  std::chrono::time_point<std::chrono::steady_clock> before = std::chrono::steady_clock::now();
+  LightSampler lights(world , light_sampling);
+  std::chrono::time_point<std::chrono::steady_clock> after = std::chrono::steady_clock::now();
+  RT_STATS(ThreadStats().AddTime(StatPhase::BUILD , after - before);)
 
-  if (b != b) {
-    b = 0.0;
-  }
+  std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(after - before);
+  std::cout << "Light-Build time : [" << duration.count() << "]ms , " << lights.NumLights() << " lights\n";
 
-  r = LinearToGamma(r);
-  g = LinearToGamma(g);
-  b = LinearToGamma(b);
+  RenderScene(world , lights);
+}
 
-  static const Interval intensity(0.000 , 0.999);
-  uint32_t ir = uint32_t(256 * intensity.Clamp(r));
-  uint32_t ig = uint32_t(256 * intensity.Clamp(g));
-  uint32_t ib = uint32_t(256 * intensity.Clamp(b));
+void Camera::Render(const Hittable& world , const Ref<Hittable>& lights) {
+  RT_STATS(ResetThreadStats();)
 
-  stream << ir << ' ' << ig << ' ' << ib << '\n';
+  RenderScene(world , LightSampler(*lights , light_sampling , false));
 }
 
-void Camera::Render(const Hittable& world , const Ref<Hittable>& lights) {
+const RenderStats& Camera::Stats() const {
+  return stats;
+}
+
+const std::vector<Color>& Camera::Pixels() const {
+  return final_pixels;
+}
+
+void Camera::RenderScene(const Hittable& world , const LightSampler& lights) {
   Initialize();
+
+  std::chrono::time_point<std::chrono::steady_clock> before , after;
+
+  const Hittable* scene = &world;
+  std::unique_ptr<CompiledScene> compiled = nullptr;
+  if (compile_world && dynamic_cast<const CompiledScene*>(&world) == nullptr) {
+    before = std::chrono::steady_clock::now();
+    compiled = std::make_unique<CompiledScene>(world);
+    after = std::chrono::steady_clock::now();
+    RT_STATS(ThreadStats().AddTime(StatPhase::BUILD , after - before);)
+
+    std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(after - before);
+    std::cout << "Scene-Compile time : [" << duration.count() << "]ms\n";
+    compiled->PrintSummary();
+
+    scene = compiled.get();
+  }
   
+  uint32_t pass_spp = sqrt_spp * sqrt_spp;
+
+  uint32_t samples_done = 0;
+  checkpoint_key = checkpointing ?
+    CheckpointKey(world , lights) : 0;
+  if (checkpointing && accumulation.Load("images/" + checkpoint_file , seed , pass_spp , checkpoint_key)) {
+    samples_done = accumulation.SampleCount(0);
+    std::cout << "resuming from images/" << checkpoint_file << " at " << samples_done << " samples per pixel\n";
+  }
+
+  /// a single pass unless checkpointing or progressive , then as many as samples_per_pixel
+  ///   needs. adaptive renders schedule their own passes
+  uint32_t target_spp = (checkpointing || progressive_passes) ?
+    glm::max(samples_per_pixel , 1u) : (adaptive ? 0 : pass_spp);
+
+  /// progressive renders with a time or noise limit may leave the sample count open
+  if (progressive_passes && samples_per_pixel == 0 && (progressive_time_budget > 0.0 || progressive_noise_threshold > 0.0)) {
+    target_spp = std::numeric_limits<uint32_t>::max() - pass_spp;
+  }
+
   std::cout << "generating pixel data...\n";
+  std::cout << "rendering " << tiles.size() << " tiles on " << thread_pool->NumWorkers() << " workers...\n";
 
-  std::chrono::time_point<std::chrono::steady_clock> before , after;
   before = std::chrono::steady_clock::now();
+  std::chrono::time_point<std::chrono::steady_clock> last_checkpoint = before;
 
-  std::latch latch(img_width * img_height);
+  uint64_t adaptive_samples = 0;
+  if (adaptive) {
+    adaptive_samples = RenderAdaptive(*scene , lights);
+  }
 
-  auto pixel_func = [this , &world , &lights , &latch](size_t i , size_t j) {
-    Color pixel_col(0 , 0 , 0);
-    for (auto s_j = 0; s_j < sqrt_spp; ++s_j) {
-      for (auto s_i = 0; s_i < sqrt_spp; ++s_i) {
-        Ray r = GetRay(i , j , s_i , s_j);
-        pixel_col += RayColor(r , max_depth , world , lights);
-      }
+  PassReport report;
+  uint32_t samples_rendered = 0;
+  while (samples_done < target_spp) {
+    std::chrono::time_point<std::chrono::steady_clock> pass_start = std::chrono::steady_clock::now();
+    first_sample = samples_done;
+
+    thread_pool->ParallelFor(tiles.size() , [this , scene , &lights](size_t task , uint32_t) {
+      RenderTile(tiles[task] , *scene , lights);
+    });
+
+    samples_done += pass_spp;
+    samples_rendered += pass_spp;
+
+    std::chrono::time_point<std::chrono::steady_clock> now = std::chrono::steady_clock::now();
+    bool last = samples_done >= target_spp;
+    if (progressive_passes) {
+      ++report.pass;
+      report.samples_per_pixel = samples_done;
+      report.seconds = std::chrono::duration<double>(now - before).count();
+      last = FinishPass(report , std::chrono::duration<double>(now - pass_start).count() , last);
+      now = std::chrono::steady_clock::now();
     }
 
-    size_t idx = i + j * img_width;
+    bool interval_passed = std::chrono::duration<double>(now - last_checkpoint).count() >= checkpoint_interval;
+    if (checkpointing && (last || interval_passed)) {
+      SaveCheckpoint();
+      last_checkpoint = std::chrono::steady_clock::now();
 
-    {
-      std::unique_lock lck(pixel_mtx);
-      final_pixels[idx] = pixel_samples_scale * pixel_col;
+      std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(last_checkpoint - now);
+      std::cout << "Checkpoint time : [" << duration.count() << "]ms , " << samples_done << " samples per pixel\n";
     }
 
-    latch.count_down();
-  };
-
-  std::cout << "spawning workers...\n";
-  for (size_t j = 0; j < img_height; ++j) {
-    for (size_t i = 0; i < img_width; ++i) {
-      workers.emplace_back(pixel_func , i , j);
+    if (last) {
+      break;
     }
   }
-  std::cout << "...workers spawned\n\n";
 
-  std::cout << "waiting for workers...\n";
-  latch.wait();
-  std::cout << "...tracing complete\n\n";
+  /// nothing left to render , the image comes straight from the checkpoint
+  if (checkpointing && samples_rendered == 0) {
+    for (const Tile& tile : tiles) {
+      std::vector<Color> tile_pixels;
+      tile_pixels.reserve(tile.NumPixels());
+      for (uint32_t j = tile.y0; j < tile.y1; ++j) {
+        for (uint32_t i = tile.x0; i < tile.x1; ++i) {
+          tile_pixels.push_back(accumulation.Average(i + j * size_t(img_width)));
+        }
+      }
+      StoreTile(tile , tile_pixels);
+    }
+  }
 
-  for (auto& worker : workers) {
-    worker.join();
+  if (active_output != OutputMode::COLOR) {
+    BuildHeatmap();
   }
-  workers.clear();
 
   after = std::chrono::steady_clock::now();
+  RT_STATS(ThreadStats().AddTime(StatPhase::TRACE , after - before);)
   
   std::cout << "...pixel data generated\n\n";
 
   std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(after - before);
-  std::cout << "Ray-Cast time : [" << duration.count() << "]ms\n\n";
+  std::cout << "Ray-Cast time : [" << duration.count() << "]ms\n";
+
+  double seconds = std::chrono::duration<double>(after - before).count();
+  double primary_rays = adaptive ?
+    double(adaptive_samples) : img_width * img_height * samples_rendered;
+  if (seconds > 0) {
+    std::cout << "Rays/sec : [" << uint64_t(primary_rays / seconds) << "] primary rays/s\n\n";
+  }
 
+  before = std::chrono::steady_clock::now();
   WriteToFile();
+  after = std::chrono::steady_clock::now();
+  RT_STATS(ThreadStats().AddTime(StatPhase::WRITE , after - before);)
+
+  RT_STATS(ReportStats();)
 }
 
 void Camera::Initialize() {
+  active_output = output_mode;
+#ifndef RT_ENABLE_STATS
+  if (active_output == OutputMode::BVH_NODES || active_output == OutputMode::PRIM_TESTS) {
+    std::cout << "bvh node and primitive test heatmaps need RT_ENABLE_STATS , writing the time heatmap instead\n";
+    active_output = OutputMode::TIME;
+  }
+#endif // !RT_ENABLE_STATS
+
+  /// a heatmap is a one off image , nothing to stream , resume or refine. adaptive renders
+  ///   schedule their own batches
+  checkpointing = !checkpoint_file.empty() && active_output == OutputMode::COLOR && !adaptive_sampling;
+  progressive_passes = progressive && active_output == OutputMode::COLOR && !adaptive_sampling;
+  adaptive = adaptive_sampling;
+  track_noise = adaptive || (progressive_passes && progressive_noise_threshold > 0.0);
+
   img_height = int32_t(img_width / aspect_ratio);
   img_height = (img_height < 1) ? 
     1 : img_height;
 
-  sqrt_spp = int32_t(glm::sqrt(samples_per_pixel));
+  /// checkpointed and progressive renders stratify each pass on its own so every
+  ///   checkpoint and estimate holds whole grids of samples
+  if (adaptive) {
+    sqrt_spp = glm::max(int32_t(glm::sqrt(adaptive_min_spp)) , 1);
+  } else {
+    sqrt_spp = !(checkpointing || progressive_passes) ?
+      int32_t(glm::sqrt(samples_per_pixel)) : glm::max(int32_t(glm::sqrt(samples_per_pass)) , 1);
+  }
 
   pixel_samples_scale = 1.0 / (sqrt_spp * sqrt_spp);
   recip_sqrt_spp = 1.0 / sqrt_spp;
@@ -145,7 +279,394 @@ void Camera::Initialize() {
   defocus_disk_u = u * defocus_radius;
   defocus_disk_v = v * defocus_radius;
 
-  final_pixels.resize(img_width * img_height);
+  output_image = nullptr;
+  if (stream_output && active_output == OutputMode::COLOR && !img_file.empty()) {
+    std::string file_name = "images/" + img_file;
+    ImageFormat format = (img_format == ImageFormat::AUTO) ?
+      FormatFromFileName(img_file) : img_format;
+
+    if (!MappedImage::Supports(format)) {
+      std::cout << "can't stream " << file_name << " , writing it once the render is done\n";
+    } else {
+      output_image = NewRef<MappedImage>();
+      if (!output_image->Create(file_name , format , uint32_t(img_width) , uint32_t(img_height))) {
+        output_image = nullptr;
+      }
+    }
+  }
+
+  if (output_image != nullptr) {
+    final_pixels.clear();
+    final_pixels.shrink_to_fit();
+  } else {
+    final_pixels.resize(img_width * img_height);
+  }
+
+  if (checkpointing || progressive_passes || adaptive) {
+    accumulation.Reset(uint32_t(img_width) , uint32_t(img_height) , track_noise);
+  }
+  active_pixels.clear();
+
+  if (active_output != OutputMode::COLOR) {
+    pixel_costs.assign(size_t(img_width) * size_t(img_height) , 0.0);
+  } else {
+    pixel_costs.clear();
+    pixel_costs.shrink_to_fit();
+  }
+
+  tiles = BuildTiles(uint32_t(img_width) , uint32_t(img_height) , tile_size);
+
+  if (thread_pool == nullptr || (num_threads != 0 && thread_pool->NumWorkers() != num_threads)) {
+    thread_pool = NewRef<ThreadPool>(num_threads);
+  }
+}
+
+void Camera::RenderTile(const Tile& tile , const Hittable& world , const LightSampler& lights) {
+  /// kept per thread , once it has held the largest tile rendering never touches the heap
+  thread_local std::vector<Color> tile_pixels;
+  tile_pixels.assign(tile.NumPixels() , Color(0 , 0 , 0));
+
+  for (uint32_t j = tile.y0; j < tile.y1; ++j) {
+    for (uint32_t i = tile.x0; i < tile.x1; ++i) {
+      size_t idx = i + j * size_t(img_width);
+      Color& pixel = tile_pixels[(i - tile.x0) + (j - tile.y0) * tile.Width()];
+
+      /// pixels an adaptive batch skips keep what they have
+      if (!active_pixels.empty() && !active_pixels[idx]) {
+        pixel = accumulation.Average(idx);
+        continue;
+      }
+
+      std::chrono::time_point<std::chrono::steady_clock> pixel_start;
+      uint64_t counter_start = 0;
+      if (active_output != OutputMode::COLOR) {
+        pixel_start = std::chrono::steady_clock::now();
+        counter_start = HeatmapCounter(active_output);
+      }
+
+      /// pixels of an adaptive render each carry on from their own sample count
+      uint32_t first = adaptive ?
+        accumulation.SampleCount(idx) : first_sample;
+
+      Color pixel_col(0 , 0 , 0);
+      for (uint32_t s_j = 0; s_j < sqrt_spp; ++s_j) {
+        for (uint32_t s_i = 0; s_i < sqrt_spp; ++s_i) {
+          ThreadRng().Seed(seed , idx , first + s_i + s_j * sqrt_spp);
+          ThreadArena().Reset();
+
+          Ray r = GetRay(i , j , s_i , s_j);
+          Color sample(0 , 0 , 0);
+          switch (integrator) {
+            case IntegratorMode::RECURSIVE:
+              sample = RayColor(r , max_depth , world , lights);
+              break;
+            case IntegratorMode::ITERATIVE:
+              sample = TracePath(r , world , lights);
+              break;
+            case IntegratorMode::MIS:
+              sample = TracePathMis(r , world , lights);
+              break;
+          }
+
+          if (track_noise) {
+            accumulation.AddSample(idx , sample);
+          } else {
+            pixel_col += sample;
+          }
+        }
+      }
+
+      if (active_output == OutputMode::TIME) {
+        pixel_costs[idx] += std::chrono::duration<double , std::nano>(std::chrono::steady_clock::now() - pixel_start).count();
+      } else if (active_output != OutputMode::COLOR) {
+        pixel_costs[idx] += double(HeatmapCounter(active_output) - counter_start);
+      }
+
+      if (track_noise) {
+        pixel = accumulation.Average(idx);
+      } else if (!checkpointing && !progressive_passes) {
+        pixel = pixel_samples_scale * pixel_col;
+      } else {
+        accumulation.Add(idx , pixel_col , sqrt_spp * sqrt_spp);
+        pixel = accumulation.Average(idx);
+      }
+    }
+  }
+
+  StoreTile(tile , tile_pixels);
+}
+
+/// pixels whose first samples all missed a rare bright path look converged while their
+///   neighbours don't , so each pixel takes the largest error of its 3x3 neighbourhood
+static constexpr int32_t error_filter_radius = 1;
+
+static void DilateErrors(std::vector<double>& errors , uint32_t width , uint32_t height) {
+  std::vector<double> rows(errors.size());
+  for (uint32_t j = 0; j < height; ++j) {
+    for (uint32_t i = 0; i < width; ++i) {
+      double e = 0.0;
+      for (int32_t d = -error_filter_radius; d <= error_filter_radius; ++d) {
+        int32_t x = glm::clamp(int32_t(i) + d , 0 , int32_t(width) - 1);
+        e = glm::max(e , errors[x + j * size_t(width)]);
+      }
+      rows[i + j * size_t(width)] = e;
+    }
+  }
+
+  for (uint32_t j = 0; j < height; ++j) {
+    for (uint32_t i = 0; i < width; ++i) {
+      double e = 0.0;
+      for (int32_t d = -error_filter_radius; d <= error_filter_radius; ++d) {
+        int32_t y = glm::clamp(int32_t(j) + d , 0 , int32_t(height) - 1);
+        e = glm::max(e , rows[i + y * size_t(width)]);
+      }
+      errors[i + j * size_t(width)] = e;
+    }
+  }
+}
+
+uint64_t Camera::RenderAdaptive(const Hittable& world , const LightSampler& lights) {
+  std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+
+  size_t num_pixels = size_t(img_width) * size_t(img_height);
+  uint64_t budget = uint64_t(glm::max(samples_per_pixel , 1u)) * num_pixels;
+
+  /// the minimum pass , every pixel gets a full stratified grid before its error is trusted
+  active_pixels.clear();
+  thread_pool->ParallelFor(tiles.size() , [this , &world , &lights](size_t task , uint32_t) {
+    RenderTile(tiles[task] , world , lights);
+  });
+
+  uint64_t samples = uint64_t(sqrt_spp * sqrt_spp) * num_pixels;
+  uint32_t num_batches = 0;
+
+  /// batches are stratified on their own like the passes of a checkpointed render
+  sqrt_spp = glm::max(uint32_t(glm::sqrt(adaptive_batch_spp)) , 1u);
+  recip_sqrt_spp = 1.0 / sqrt_spp;
+  uint32_t batch_spp = sqrt_spp * sqrt_spp;
+
+  std::vector<double> errors(num_pixels);
+  std::vector<uint32_t> candidates;
+  std::vector<size_t> batch_tiles;
+  size_t num_noisy = 0;
+
+  while (true) {
+    for (size_t p = 0; p < num_pixels; ++p) {
+      errors[p] = accumulation.DisplayError(p);
+    }
+    DilateErrors(errors , uint32_t(img_width) , uint32_t(img_height));
+
+    candidates.clear();
+    for (size_t p = 0; p < num_pixels; ++p) {
+      if (errors[p] > adaptive_threshold) {
+        candidates.push_back(uint32_t(p));
+      }
+    }
+    num_noisy = candidates.size();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    bool out_of_time = adaptive_time_budget > 0.0 && seconds >= adaptive_time_budget;
+
+    uint64_t affordable = (budget > samples) ?
+      (budget - samples) / batch_spp : 0;
+    if (candidates.empty() || out_of_time || affordable == 0) {
+      break;
+    }
+
+    /// the noisiest pixels first when the budget doesn't cover every one of them
+    if (candidates.size() > affordable) {
+      std::nth_element(candidates.begin() , candidates.begin() + affordable , candidates.end() , [&errors](uint32_t a , uint32_t b) {
+        return errors[a] > errors[b];
+      });
+      candidates.resize(affordable);
+    }
+
+    active_pixels.assign(num_pixels , 0);
+    for (uint32_t p : candidates) {
+      active_pixels[p] = 1;
+    }
+
+    batch_tiles.clear();
+    for (size_t t = 0; t < tiles.size(); ++t) {
+      const Tile& tile = tiles[t];
+      bool any_active = false;
+      for (uint32_t j = tile.y0; j < tile.y1 && !any_active; ++j) {
+        for (uint32_t i = tile.x0; i < tile.x1 && !any_active; ++i) {
+          any_active = active_pixels[i + j * size_t(img_width)] != 0;
+        }
+      }
+
+      if (any_active) {
+        batch_tiles.push_back(t);
+      }
+    }
+
+    thread_pool->ParallelFor(batch_tiles.size() , [this , &world , &lights , &batch_tiles](size_t task , uint32_t) {
+      RenderTile(tiles[batch_tiles[task]] , world , lights);
+    });
+
+    samples += uint64_t(candidates.size()) * batch_spp;
+    ++num_batches;
+  }
+
+  active_pixels.clear();
+
+  uint32_t min_count = accumulation.SampleCount(0);
+  uint32_t max_count = 0;
+  for (size_t p = 0; p < num_pixels; ++p) {
+    min_count = glm::min(min_count , accumulation.SampleCount(p));
+    max_count = glm::max(max_count , accumulation.SampleCount(p));
+  }
+
+  std::cout << "Adaptive sampling : " << num_batches << " batches , " << double(samples) / double(num_pixels)
+            << " samples per pixel on average (" << min_count << " to " << max_count << ") , "
+            << num_noisy << " of " << num_pixels << " pixels above the threshold\n";
+
+  WriteSampleCounts();
+
+  return samples;
+}
+
+bool Camera::WriteSampleCounts() const {
+  if (sample_count_file.empty() && img_file.empty()) {
+    return true;
+  }
+
+  std::string file_name = "images/" + (sample_count_file.empty() ? img_file + ".spp.pfm" : sample_count_file);
+
+  std::vector<Color> counts(size_t(img_width) * size_t(img_height));
+  for (size_t p = 0; p < counts.size(); ++p) {
+    float count = float(accumulation.SampleCount(p));
+    counts[p] = Color(count , count , count);
+  }
+
+  return WriteImage(file_name , ImageFormat::PFM , uint32_t(img_width) , uint32_t(img_height) , counts , thread_pool.get());
+}
+
+void Camera::StoreTile(const Tile& tile , const std::vector<Color>& tile_pixels) {
+  /// tiles never overlap so every pixel has exactly one writer
+  if (output_image != nullptr) {
+    output_image->WriteRect(tile.x0 , tile.y0 , tile.Width() , tile.Height() , tile_pixels.data());
+    return;
+  }
+
+  for (uint32_t j = tile.y0; j < tile.y1; ++j) {
+    std::copy_n(tile_pixels.data() + (j - tile.y0) * tile.Width() , tile.Width() , final_pixels.data() + tile.x0 + j * size_t(img_width));
+  }
+}
+
+void Camera::BuildHeatmap() {
+  if (pixel_costs.empty()) {
+    return;
+  }
+
+  /// the top is a high percentile instead of the maximum , a single pixel the scheduler
+  ///   preempted would otherwise push everything else into the cold end
+  std::vector<double> sorted = pixel_costs;
+  size_t top_idx = std::min(sorted.size() - 1 , size_t(double(sorted.size()) * 0.999));
+  std::nth_element(sorted.begin() , sorted.begin() + top_idx , sorted.end());
+  double top = sorted[top_idx];
+  double bottom = *std::min_element(sorted.begin() , sorted.begin() + top_idx + 1);
+
+  double sum = 0.0;
+  for (double cost : pixel_costs) {
+    sum += cost;
+  }
+
+  /// costs span orders of magnitude between empty sky and dense media , log scaled
+  double log_bottom = glm::log(1.0 + bottom);
+  double log_range = glm::log(1.0 + top) - log_bottom;
+
+  final_pixels.resize(pixel_costs.size());
+  for (size_t i = 0; i < pixel_costs.size(); ++i) {
+    double t = (log_range > 0.0) ?
+      (glm::log(1.0 + pixel_costs[i]) - log_bottom) / log_range : 0.0;
+    final_pixels[i] = FalseColor(t);
+  }
+
+  const char* unit = (active_output == OutputMode::TIME) ?
+    "ns" : (active_output == OutputMode::BVH_NODES ? "bvh nodes" : "primitive tests");
+  std::cout << "Heatmap : " << uint64_t(bottom) << " to " << uint64_t(top) << " " << unit << " per pixel , mean "
+            << uint64_t(sum / double(pixel_costs.size())) << "\n";
+}
+
+uint64_t Camera::CheckpointKey(const Hittable& world , const LightSampler& lights) const {
+  uint64_t key = HashBytes(&scene_hash , sizeof(scene_hash));
+  auto add = [&key](const auto& value) {
+    key = HashBytes(&value , sizeof(value) , key);
+  };
+
+  Aabb bounds = world.BoundingBox();
+  for (const Interval& axis : { bounds.x , bounds.y , bounds.z }) {
+    add(axis.min);
+    add(axis.max);
+  }
+  add(uint64_t(lights.NumLights()));
+
+  add(aspect_ratio);
+  add(vfov);
+  add(defocus_angle);
+  add(focus_dist);
+  add(camera_loc);
+  add(target);
+  add(vup);
+  add(background);
+  add(max_depth);
+  add(rr_min_depth);
+  add(integrator);
+  add(light_sampling);
+
+  return key;
+}
+
+bool Camera::SaveCheckpoint() const {
+  return accumulation.Save("images/" + checkpoint_file , seed , sqrt_spp * sqrt_spp , checkpoint_key);
+}
+
+bool Camera::FinishPass(PassReport& report , double pass_seconds , bool last) {
+  if (track_noise) {
+    report.noise = accumulation.RmsDisplayError();
+    last = last || report.noise <= progressive_noise_threshold;
+  }
+
+  /// the next pass takes about as long as this one
+  if (progressive_time_budget > 0.0 && report.seconds + pass_seconds > progressive_time_budget) {
+    last = true;
+  }
+  report.last = last;
+
+  std::cout << "Pass " << report.pass << " : [" << uint64_t(pass_seconds * 1e3) << "]ms , "
+            << report.samples_per_pixel << " samples per pixel";
+  if (track_noise) {
+    std::cout << " , noise " << report.noise;
+  }
+  std::cout << "\n";
+
+  /// the last estimate is written with the finished image , a streamed one is already in
+  ///   img_file
+  if (!last && output_image == nullptr) {
+    WriteToFile();
+  }
+
+  if (on_pass != nullptr) {
+    on_pass(report , final_pixels);
+  }
+
+  return last;
+}
+
+void Camera::ReportStats() {
+  stats = CollectThreadStats();
+  stats.Print();
+
+  if (stats_file.empty() && img_file.empty()) {
+    return;
+  }
+
+  std::string file_name = "images/" + (stats_file.empty() ? img_file + ".stats.json" : stats_file);
+  if (stats.WriteJson(file_name)) {
+    std::cout << "Render stats written to " << file_name << "\n\n";
+  }
 }
 
 Ray Camera::GetRay(uint32_t i , uint32_t j , uint32_t s_i , uint32_t s_j) const {
@@ -183,11 +704,13 @@ Point3 Camera::DefocusDiskSample() const {
   return center + (p.x * defocus_disk_u) + (p.y * defocus_disk_v);
 }
     
-Color Camera::RayColor(const Ray& r , int32_t depth , const Hittable& world , const Ref<Hittable>& lights) const {
+Color Camera::RayColor(const Ray& r , int32_t depth , const Hittable& world , const LightSampler& lights) const {
   if (depth <= 0) {
     return Color(0 , 0 , 0);
   }
 
+  RT_STATS(ThreadStats().AddRay(depth == max_depth ? StatRay::CAMERA : StatRay::BOUNCE , max_depth - depth);)
+
   HitRecord rec;
 
   if (!world.Hit(r , Interval(0.001 , infinity) , rec)) {
@@ -199,6 +722,8 @@ Color Camera::RayColor(const Ray& r , int32_t depth , const Hittable& world , co
     return Color(0 , 0 , 0);
   }
 
+  RT_STATS(ThreadStats().AddMaterialHit(rec.mat->StatsCategory());)
+
   ScatterRecord srec;
   Color color_from_emission = rec.mat->Emitted(r , rec , rec.u , rec.v , rec.point);
 
@@ -210,12 +735,10 @@ Color Camera::RayColor(const Ray& r , int32_t depth , const Hittable& world , co
     return srec.attenuation * RayColor(srec.skip_pdf_ray , depth - 1 , world , lights);
   }
 
-#if 1
-  Ref<Pdf> pdf = NewRef<HittablePdf>(lights , rec.point);
-  // Ref<Pdf> pdf = NewRef<MixturePdf>(light_ptr , srec.pdf);
-#else
-  Ref<Pdf> pdf = srec.pdf;
-#endif
+  HittablePdf light_pdf(lights , rec.point , r.Time());
+  MixturePdf mixture(&light_pdf , srec.GetPdf());
+  const Pdf* pdf = lights.Empty() ?
+    srec.GetPdf() : &mixture;
 
   Ray scattered = Ray(rec.point , pdf->Generate() , r.Time());
   auto pdf_val = pdf->Value(scattered.Direction());
@@ -228,29 +751,212 @@ Color Camera::RayColor(const Ray& r , int32_t depth , const Hittable& world , co
   return color_from_emission + color_from_scatter;
 }
 
+Color Camera::TracePath(const Ray& r , const Hittable& world , const LightSampler& lights) const {
+  Color radiance(0 , 0 , 0);
+  Color throughput(1 , 1 , 1);
+  Ray ray = r;
+  RT_STATS(RenderStats& thread_stats = ThreadStats();)
+
+  for (int32_t depth = 0; max_depth <= 0 || depth < max_depth; ++depth) {
+    RT_STATS(thread_stats.AddRay(depth == 0 ? StatRay::CAMERA : StatRay::BOUNCE , depth);)
+
+    HitRecord rec;
+
+    if (!world.Hit(ray , Interval(0.001 , infinity) , rec)) {
+      radiance += throughput * background;
+      break;
+    }
+
+    /// this should never happen
+    if (rec.mat == nullptr) {
+      break;
+    }
+
+    RT_STATS(thread_stats.AddMaterialHit(rec.mat->StatsCategory());)
+
+    ScatterRecord srec;
+    radiance += throughput * rec.mat->Emitted(ray , rec , rec.u , rec.v , rec.point);
+
+    if (!rec.mat->Scatter(ray , rec , srec)) {
+      break;
+    }
+
+    if (srec.skip_pdf) {
+      throughput *= srec.attenuation;
+      ray = srec.skip_pdf_ray;
+    } else {
+      /// half the directions aim at the lights and half follow the material , light only
+      ///   sampling would never see the light bounced off other surfaces
+      HittablePdf light_pdf(lights , rec.point , ray.Time());
+      MixturePdf mixture(&light_pdf , srec.GetPdf());
+      const Pdf* pdf = lights.Empty() ?
+        srec.GetPdf() : &mixture;
+
+      Ray scattered = Ray(rec.point , pdf->Generate() , ray.Time());
+      auto pdf_val = pdf->Value(scattered.Direction());
+
+      double scattering_pdf = rec.mat->ScatteringPdf(ray , rec , scattered);
+
+      throughput *= srec.attenuation * float(scattering_pdf / pdf_val);
+      ray = scattered;
+    }
+
+    /// russian roulette, survivors are reweighted so the estimate stays unbiased
+    if (rr_min_depth >= 0 && depth >= rr_min_depth) {
+      double survive = glm::min(double(glm::max(throughput.x , glm::max(throughput.y , throughput.z))) , 0.95);
+      if (!(survive > 0) || RandomDouble() >= survive) {
+        RT_STATS(++thread_stats.rr_terminations;)
+        break;
+      }
+
+      throughput *= float(1.0 / survive);
+    }
+  }
+
+  return radiance;
+}
+
+Color Camera::TracePathMis(const Ray& r , const Hittable& world , const LightSampler& lights) const {
+  Color radiance(0 , 0 , 0);
+  Color throughput(1 , 1 , 1);
+  Ray ray = r;
+  RT_STATS(RenderStats& thread_stats = ThreadStats();)
+
+  /// pdf the bsdf had of picking ray , 0 for camera rays and specular bounces whose
+  ///   emission no light sample could have found
+  double bsdf_pdf = 0.0;
+
+  for (int32_t depth = 0; max_depth <= 0 || depth < max_depth; ++depth) {
+    RT_STATS(thread_stats.AddRay(depth == 0 ? StatRay::CAMERA : StatRay::BOUNCE , depth);)
+
+    HitRecord rec;
+
+    if (!world.Hit(ray , Interval(0.001 , infinity) , rec)) {
+      radiance += throughput * background;
+      break;
+    }
+
+    /// this should never happen
+    if (rec.mat == nullptr) {
+      break;
+    }
+
+    RT_STATS(thread_stats.AddMaterialHit(rec.mat->StatsCategory());)
+
+    Color emitted = rec.mat->Emitted(ray , rec , rec.u , rec.v , rec.point);
+    if (bsdf_pdf > 0.0 && !lights.Empty()) {
+      double light_pdf = lights.PdfValue(ray.Origin() , ray.Direction() , ray.Time());
+      emitted *= float(PowerHeuristic(bsdf_pdf , light_pdf));
+    }
+    radiance += throughput * emitted;
+
+    ScatterRecord srec;
+    if (!rec.mat->Scatter(ray , rec , srec)) {
+      break;
+    }
+
+    if (srec.skip_pdf) {
+      throughput *= srec.attenuation;
+      ray = srec.skip_pdf_ray;
+      bsdf_pdf = 0.0;
+    } else {
+      const Pdf* pdf = srec.GetPdf();
+
+      /// next event estimation. the shadow ray takes whatever emission it reaches first so
+      ///   emitters the sampler doesn't know of , or that hide its lights , stay consistent
+      ///   with the bsdf side. skipped on the last bounce as the bsdf side can't match it
+      bool last_bounce = max_depth > 0 && depth + 1 >= max_depth;
+      if (!lights.Empty() && !last_bounce) {
+        Ray shadow(rec.point , lights.Random(rec.point , ray.Time()) , ray.Time());
+        double light_pdf = lights.PdfValue(shadow.Origin() , shadow.Direction() , shadow.Time());
+
+        RT_STATS(if (light_pdf > 0.0) { thread_stats.AddRay(StatRay::SHADOW , depth); })
+
+        HitRecord light_rec;
+        if (light_pdf > 0.0 && world.Hit(shadow , Interval(0.001 , infinity) , light_rec) && light_rec.mat != nullptr) {
+          Color light_emitted = light_rec.mat->Emitted(shadow , light_rec , light_rec.u , light_rec.v , light_rec.point);
+          double scattering_pdf = rec.mat->ScatteringPdf(ray , rec , shadow);
+
+          if (scattering_pdf > 0.0) {
+            double weight = PowerHeuristic(light_pdf , pdf->Value(shadow.Direction()));
+            radiance += throughput * srec.attenuation * light_emitted * float(scattering_pdf * weight / light_pdf);
+          }
+        }
+      }
+
+      Ray scattered = Ray(rec.point , pdf->Generate() , ray.Time());
+      bsdf_pdf = pdf->Value(scattered.Direction());
+      if (!(bsdf_pdf > 0.0)) {
+        break;
+      }
+
+      double scattering_pdf = rec.mat->ScatteringPdf(ray , rec , scattered);
+
+      throughput *= srec.attenuation * float(scattering_pdf / bsdf_pdf);
+      ray = scattered;
+    }
+
+    /// russian roulette, survivors are reweighted so the estimate stays unbiased
+    if (rr_min_depth >= 0 && depth >= rr_min_depth) {
+      double survive = glm::min(double(glm::max(throughput.x , glm::max(throughput.y , throughput.z))) , 0.95);
+      if (!(survive > 0) || RandomDouble() >= survive) {
+        RT_STATS(++thread_stats.rr_terminations;)
+        break;
+      }
+
+      throughput *= float(1.0 / survive);
+    }
+  }
+
+  return radiance;
+}
+
 void Camera::WriteToFile() {
-  std::cout << "writing to image...\n";
-  
+  if (img_file.empty()) {
+    return;
+  }
+
+  std::string file_name = "images/" + img_file;
+
+  if (output_image != nullptr) {
+    std::chrono::time_point<std::chrono::steady_clock> before = std::chrono::steady_clock::now();
+    bool flushed = output_image->Flush();
+    std::chrono::time_point<std::chrono::steady_clock> after = std::chrono::steady_clock::now();
+
+    if (!flushed) {
+      std::cerr << "ERROR : Failed to flush image file : " << file_name << "\n";
+    }
+
+    std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(after - before);
+    std::cout << "Image-Flush time : [" << duration.count() << "]ms , " << output_image->FileSize() << " bytes streamed to " << file_name << "\n\n";
+
+    output_image = nullptr;
+    return;
+  }
+
+  std::cout << "Writing image : " << file_name << std::endl;
+
+  ImageFormat format = (img_format == ImageFormat::AUTO) ?
+    FormatFromFileName(img_file) : img_format;
+
   std::chrono::time_point<std::chrono::steady_clock> before = std::chrono::steady_clock::now();
 
-  std::ofstream img("images/" + img_file);
-  if (!img.is_open()) {
-    std::cout << "file not open" << std::endl;
+  std::vector<uint8_t> file_data;
+  if (!EncodeImage(format , uint32_t(img_width) , uint32_t(img_height) , final_pixels , file_data , thread_pool.get())) {
+    std::cerr << "ERROR : Failed to encode image : " << file_name << "\n";
     return;
-  } else {
-    std::cout << "Writing image : images/" << img_file << std::endl;
   }
 
-  img << "P3\n" << img_width << ' ' << img_height << "\n255\n";
+  std::chrono::time_point<std::chrono::steady_clock> encoded = std::chrono::steady_clock::now();
 
-  for (auto& pixel : final_pixels) {
-    WriteColor(img , pixel);
+  if (!WriteFileData(file_name , file_data)) {
+    return;
   }
 
   std::chrono::time_point<std::chrono::steady_clock> after = std::chrono::steady_clock::now();
 
-  std::cout << "...image complete" << std::endl;
-  
-  std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(after - before);
-  std::cout << "Image-Write time : [" << duration.count() << "]ms\n\n";
+  std::chrono::milliseconds encode_duration = std::chrono::duration_cast<std::chrono::milliseconds>(encoded - before);
+  std::chrono::milliseconds write_duration = std::chrono::duration_cast<std::chrono::milliseconds>(after - encoded);
+  std::cout << "Image-Encode time : [" << encode_duration.count() << "]ms\n";
+  std::cout << "Image-Write time : [" << write_duration.count() << "]ms , " << file_data.size() << " bytes\n\n";
 }
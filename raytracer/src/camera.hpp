@@ -4,14 +4,57 @@
 #ifndef CAMERA_HPP
 #define CAMERA_HPP
 
+#include <functional>
 #include <string>
 #include <vector>
-#include <mutex>
-#include <thread>
 
 #include "defines.hpp"
+#include "accumulation_buffer.hpp"
 #include "ray.hpp"
 #include "hittable.hpp"
+#include "light_sampler.hpp"
+#include "render_stats.hpp"
+#include "image_writer.hpp"
+#include "thread_pool.hpp"
+#include "tile.hpp"
+
+enum class IntegratorMode {
+  /// original recursive estimator, kept for A/B comparisons
+  RECURSIVE ,
+  /// iterative path tracer carrying throughput with russian roulette termination
+  ITERATIVE ,
+  /// ITERATIVE with a light sample at every diffuse bounce next to the bsdf sample ,
+  ///   both weighted by the power heuristic
+  MIS ,
+};
+
+/// what img_file receives. the heatmaps still render the image but write the cost of every
+///   pixel instead , log scaled onto a false color ramp from dark blue (cheapest) to dark
+///   red (most expensive)
+enum class OutputMode {
+  COLOR ,
+  /// wall clock nanoseconds spent on the pixel
+  TIME ,
+  /// bvh nodes visited by every ray of the pixel , needs RT_ENABLE_STATS
+  BVH_NODES ,
+  /// primitive intersection tests of every ray of the pixel , needs RT_ENABLE_STATS
+  PRIM_TESTS ,
+};
+
+/// where a progressive render stands after one of its passes
+struct PassReport {
+  uint32_t pass = 0;
+  uint32_t samples_per_pixel = 0;
+
+  /// since the first pass started
+  double seconds = 0.0;
+
+  /// rms display error , 0 unless progressive_noise_threshold is set
+  double noise = 0.0;
+
+  /// no further pass follows
+  bool last = false;
+};
 
 class Camera {
   public:
@@ -33,15 +76,134 @@ class Camera {
     Color background;
 
     uint32_t samples_per_pixel = 10;
+
+    /// hard bounce cap, the iterative integrator treats max_depth <= 0 as uncapped
     int32_t max_depth = 10;
 
+    IntegratorMode integrator = IntegratorMode::MIS;
+
+    /// bounces every path survives before russian roulette may terminate it, negative disables roulette
+    int32_t rr_min_depth = 3;
+
+    /// written under images/ , empty keeps the image in memory only where Pixels returns it.
+    ///   the stats and sample count files then need names of their own to be written
     std::string img_file = "image.ppm";
 
+    /// AUTO picks the format from the extension of img_file , .ppm is binary P6
+    ImageFormat img_format = ImageFormat::AUTO;
+
+    /// heatmaps ignore stream_output and checkpoint_file. without RT_ENABLE_STATS the
+    ///   counter heatmaps fall back to TIME
+    OutputMode output_mode = OutputMode::COLOR;
+
+    /// finished tiles are encoded straight into img_file mapped into memory instead of
+    ///   gathering the frame first , memory then only holds the tiles in flight and the
+    ///   file can be opened mid render. needs a ppm or pfm file , others are written whole
+    bool stream_output = false;
+
+    /// file under images/ the accumulated samples are saved to between passes , a later
+    ///   render with the same file , scene , view , integrator , size , seed and
+    ///   samples_per_pass picks up from it and only adds the samples still missing. empty
+    ///   renders every sample in a single pass
+    std::string checkpoint_file = "";
+
+    /// identifies the world for checkpoints , LoadScene sets the hash of every statement but
+    ///   the camera and output ones. mesh files are known by path only. worlds built in code
+    ///   can set their own , with 0 only the bounds and number of lights tell them apart
+    uint64_t scene_hash = 0;
+
+    /// samples per pixel of each pass of a checkpointed render , rounded down to a square.
+    ///   samples_per_pixel is rounded up to whole passes
+    uint32_t samples_per_pass = 16;
+
+    /// seconds between checkpoints , the last pass is always saved
+    double checkpoint_interval = 300.0;
+
+    /// render in passes of samples_per_pass into the accumulation buffer and write the
+    ///   estimate so far to img_file after each one , so a usable image exists from the first
+    ///   pass on. stops at samples_per_pixel , once progressive_time_budget would run out or
+    ///   the noise drops under progressive_noise_threshold , whichever comes first. works
+    ///   together with checkpoint_file , ignored by heatmaps and adaptive renders
+    bool progressive = false;
+
+    /// seconds of passes , a pass only starts when the last one says it still fits. 0 leaves
+    ///   the other limits , with none of them set samples_per_pixel = 0 renders a single pass
+    double progressive_time_budget = 0.0;
+
+    /// rms over the image of the standard error of every pixel as displayed by the 8 bit
+    ///   formats , 1/255 is one step. 0 doesn't estimate the noise at all
+    double progressive_noise_threshold = 0.0;
+
+    /// called after every pass of a progressive render with the current estimate , pixels is
+    ///   empty while streaming since img_file already holds it
+    std::function<void(const PassReport& report , const std::vector<Color>& pixels)> on_pass = nullptr;
+
+    /// spend samples where the image is noisy instead of samples_per_pixel on every pixel.
+    ///   every pixel gets a stratified grid of adaptive_min_spp samples first , after that
+    ///   batches of adaptive_batch_spp only go to pixels whose estimated error is above
+    ///   adaptive_threshold. stops once every pixel is below it , the image used
+    ///   samples_per_pixel samples per pixel on average or adaptive_time_budget ran out.
+    ///   checkpoint_file is ignored
+    bool adaptive_sampling = false;
+
+    /// both rounded down to a square
+    uint32_t adaptive_min_spp = 16;
+    uint32_t adaptive_batch_spp = 4;
+
+    /// standard error of a pixel as displayed by the 8 bit formats , 1/255 is one step
+    double adaptive_threshold = 0.004;
+
+    /// seconds , 0 leaves only the sample budget
+    double adaptive_time_budget = 0.0;
+
+    /// file under images/ the sample count of every pixel of an adaptive render is written to ,
+    ///   as a pfm with the count in every channel. empty appends .spp.pfm to img_file
+    std::string sample_count_file = "";
+
+    /// every sample draws from a stream keyed by (seed , pixel , sample) so renders are
+    ///   bit-reproducible regardless of thread count or scheduling order
+    uint64_t seed = 0;
+
+    /// number of render threads, 0 uses every hardware thread
+    uint32_t num_threads = 0;
+
+    /// edge length in pixels of the square tiles handed to the workers
+    uint32_t tile_size = 16;
+
+    /// created on first render and reused by every later one, can be shared between cameras
+    Ref<ThreadPool> thread_pool = nullptr;
+
+    /// lower the world into a CompiledScene before rendering , skipped when it already is one
+    bool compile_world = true;
+
+    /// how a light is picked for each light sample
+    LightSampling light_sampling = LightSampling::BVH;
+
+    /// file under images/ the statistics of every render are written to as json , empty
+    ///   appends .stats.json to img_file. only used when built with RT_ENABLE_STATS
+    std::string stats_file = "";
+
+    /// lights are collected from the emissive materials of world. RECURSIVE and ITERATIVE
+    ///   mix light and material sampling evenly at every bounce , MIS weights one sample of
+    ///   each. without any lights the materials are sampled alone
+    void Render(const Hittable& world);
+
+    /// samples the surfaces of lights instead of the emissive ones , whatever their materials
     void Render(const Hittable& world , const Ref<Hittable>& lights); 
 
+    /// counters of the last render , all zero unless built with RT_ENABLE_STATS
+    const RenderStats& Stats() const;
+
+    /// linear color of the last render row by row , empty when it was streamed
+    const std::vector<Color>& Pixels() const;
+
   private:
+    /// side of the grid of strata of one pass
     uint32_t sqrt_spp = 0;
 
+    /// sample index the current pass starts at
+    uint32_t first_sample = 0;
+
     double img_height;
     double pixel_samples_scale;
     double recip_sqrt_spp;
@@ -58,12 +220,66 @@ class Camera {
     glm::vec3 defocus_disk_u;
     glm::vec3 defocus_disk_v;
 
-    std::mutex pixel_mtx;
+    /// empty while streaming
     std::vector<Color> final_pixels{};
-    std::vector<std::thread> workers{};
+    std::vector<Tile> tiles{};
+
+    /// open during a streamed render
+    Ref<MappedImage> output_image = nullptr;
+
+    /// only used by checkpointed renders
+    AccumulationBuffer accumulation;
+
+    /// stored in checkpoints , a render only resumes one with the same key
+    uint64_t checkpoint_key = 0;
+
+    /// output_mode , checkpoint_file , progressive and adaptive_sampling as this render uses them
+    OutputMode active_output = OutputMode::COLOR;
+    bool checkpointing = false;
+    bool progressive_passes = false;
+    bool adaptive = false;
+
+    /// samples go into the accumulation buffer one at a time so it can estimate the noise
+    bool track_noise = false;
+
+    /// pixels the current adaptive batch samples , empty samples every pixel
+    std::vector<uint8_t> active_pixels{};
+
+    /// cost of every pixel while rendering a heatmap
+    std::vector<double> pixel_costs{};
+
+    RenderStats stats;
 
     void Initialize();
 
+    void RenderScene(const Hittable& world , const LightSampler& lights);
+
+    void RenderTile(const Tile& tile , const Hittable& world , const LightSampler& lights);
+
+    /// the minimum pass and every batch after it , returns the number of samples taken
+    uint64_t RenderAdaptive(const Hittable& world , const LightSampler& lights);
+
+    bool WriteSampleCounts() const;
+
+    /// hands finished pixels of tile to the output image or final_pixels
+    void StoreTile(const Tile& tile , const std::vector<Color>& tile_pixels);
+
+    /// scene_hash , the world bounds and number of lights and every setting the samples
+    ///   depend on that the checkpoint doesn't store on its own
+    uint64_t CheckpointKey(const Hittable& world , const LightSampler& lights) const;
+
+    bool SaveCheckpoint() const;
+
+    /// checks the limits of a progressive render after a pass , last is whether the sample
+    ///   target is reached. prints and hands on the estimate , true when no pass follows
+    bool FinishPass(PassReport& report , double pass_seconds , bool last);
+
+    /// replaces final_pixels with the false color map of pixel_costs
+    void BuildHeatmap();
+
+    /// merges the counters of every thread into stats , prints and saves them
+    void ReportStats();
+
     Ray GetRay(uint32_t i , uint32_t j , uint32_t s_i , uint32_t s_j) const;
 
     glm::vec3 SampleSquare() const;
@@ -74,7 +290,11 @@ class Camera {
 
     Point3 DefocusDiskSample() const;
 
-    Color RayColor(const Ray& r , int32_t depth , const Hittable& world , const Ref<Hittable>& lights) const;
+    Color RayColor(const Ray& r , int32_t depth , const Hittable& world , const LightSampler& lights) const;
+
+    Color TracePath(const Ray& r , const Hittable& world , const LightSampler& lights) const;
+
+    Color TracePathMis(const Ray& r , const Hittable& world , const LightSampler& lights) const;
 
     void WriteToFile();
 };
@@ -0,0 +1,689 @@
+/**
+ * \file compiled_scene.cpp
+ **/
+#include "compiled_scene.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "constant_medium.hpp"
+#include "light_sampler.hpp"
+#include "material.hpp"
+#include "render_stats.hpp"
+#include "scene_cache.hpp"
+#include "sphere.hpp"
+
+void SphereArrays::Append(const SphereArrays& src , uint32_t i) {
+  center_x.push_back(src.center_x[i]);
+  center_y.push_back(src.center_y[i]);
+  center_z.push_back(src.center_z[i]);
+  radius.push_back(src.radius[i]);
+  material.push_back(src.material[i]);
+}
+
+void MovingSphereArrays::Append(const MovingSphereArrays& src , uint32_t i) {
+  center_x.push_back(src.center_x[i]);
+  center_y.push_back(src.center_y[i]);
+  center_z.push_back(src.center_z[i]);
+  move_x.push_back(src.move_x[i]);
+  move_y.push_back(src.move_y[i]);
+  move_z.push_back(src.move_z[i]);
+  radius.push_back(src.radius[i]);
+  material.push_back(src.material[i]);
+}
+
+void QuadArrays::Append(const QuadArrays& src , uint32_t i) {
+  q_x.push_back(src.q_x[i]);
+  q_y.push_back(src.q_y[i]);
+  q_z.push_back(src.q_z[i]);
+  u_x.push_back(src.u_x[i]);
+  u_y.push_back(src.u_y[i]);
+  u_z.push_back(src.u_z[i]);
+  v_x.push_back(src.v_x[i]);
+  v_y.push_back(src.v_y[i]);
+  v_z.push_back(src.v_z[i]);
+  normal_x.push_back(src.normal_x[i]);
+  normal_y.push_back(src.normal_y[i]);
+  normal_z.push_back(src.normal_z[i]);
+  w_x.push_back(src.w_x[i]);
+  w_y.push_back(src.w_y[i]);
+  w_z.push_back(src.w_z[i]);
+  d.push_back(src.d[i]);
+  material.push_back(src.material[i]);
+}
+
+void MediumArrays::Append(const MediumArrays& src , uint32_t i) {
+  boundary.push_back(src.boundary[i]);
+  neg_inv_density.push_back(src.neg_inv_density[i]);
+  material.push_back(src.material[i]);
+}
+
+void InstanceArrays::Append(const InstanceArrays& src , uint32_t i) {
+  to_object.push_back(src.to_object[i]);
+  blas.push_back(src.blas[i]);
+}
+
+void GenericArrays::Append(const GenericArrays& src , uint32_t i) {
+  object.push_back(src.object[i]);
+}
+
+SceneCompiler::SceneCompiler(const BvhBuildOptions& options , SceneCacheReader* reader)
+    : options(options) , reader(reader) {}
+
+void SceneCompiler::AddSphere(const Point3& center , double radius , const Ref<Material>& mat) {
+  uint32_t index = uint32_t(spheres.radius.size());
+  spheres.center_x.push_back(center.x);
+  spheres.center_y.push_back(center.y);
+  spheres.center_z.push_back(center.z);
+  spheres.radius.push_back(float(radius));
+  spheres.material.push_back(MaterialId(mat));
+
+  auto rvec = glm::vec3(radius , radius , radius);
+  AddPrim(PrimType::SPHERE , index , Aabb(center - rvec , center + rvec));
+}
+
+void SceneCompiler::AddMovingSphere(const Point3& center1 , const glm::vec3& center_vec , double radius , const Ref<Material>& mat) {
+  uint32_t index = uint32_t(moving_spheres.radius.size());
+  moving_spheres.center_x.push_back(center1.x);
+  moving_spheres.center_y.push_back(center1.y);
+  moving_spheres.center_z.push_back(center1.z);
+  moving_spheres.move_x.push_back(center_vec.x);
+  moving_spheres.move_y.push_back(center_vec.y);
+  moving_spheres.move_z.push_back(center_vec.z);
+  moving_spheres.radius.push_back(float(radius));
+  moving_spheres.material.push_back(MaterialId(mat));
+
+  auto rvec = glm::vec3(radius , radius , radius);
+  Point3 center2 = center1 + center_vec;
+  AddPrim(PrimType::MOVING_SPHERE , index , Aabb(Aabb(center1 - rvec , center1 + rvec) , Aabb(center2 - rvec , center2 + rvec)));
+}
+
+void SceneCompiler::AddQuad(const Point3& Q , const glm::vec3& u , const glm::vec3& v , const glm::vec3& normal ,
+                            const glm::vec3& w , double D , const Ref<Material>& mat) {
+  uint32_t index = uint32_t(quads.d.size());
+  quads.q_x.push_back(Q.x);
+  quads.q_y.push_back(Q.y);
+  quads.q_z.push_back(Q.z);
+  quads.u_x.push_back(u.x);
+  quads.u_y.push_back(u.y);
+  quads.u_z.push_back(u.z);
+  quads.v_x.push_back(v.x);
+  quads.v_y.push_back(v.y);
+  quads.v_z.push_back(v.z);
+  quads.normal_x.push_back(normal.x);
+  quads.normal_y.push_back(normal.y);
+  quads.normal_z.push_back(normal.z);
+  quads.w_x.push_back(w.x);
+  quads.w_y.push_back(w.y);
+  quads.w_z.push_back(w.z);
+  quads.d.push_back(D);
+  quads.material.push_back(MaterialId(mat));
+
+  AddPrim(PrimType::QUAD , index , Aabb(Aabb(Q , Q + u + v) , Aabb(Q + u , Q + v)));
+}
+
+void SceneCompiler::AddMedium(const Hittable& boundary , double neg_inv_density , const Ref<Material>& phase_function) {
+  uint32_t index = uint32_t(media.boundary.size());
+  media.boundary.push_back(&boundary);
+  media.neg_inv_density.push_back(neg_inv_density);
+  media.material.push_back(MaterialId(phase_function));
+
+  AddPrim(PrimType::MEDIUM , index , boundary.BoundingBox());
+}
+
+void SceneCompiler::AddInstance(const Hittable& object , const Transform& transform) {
+  uint32_t blas = 0;
+
+  auto itr = blas_ids.find(&object);
+  if (itr != blas_ids.end()) {
+    blas = itr->second;
+  } else {
+    Ref<CompiledScene> scene = (reader != nullptr) ?
+      CompiledScene::Load(object , *reader) : nullptr;
+    if (scene == nullptr) {
+      scene = NewRef<CompiledScene>(object , options);
+    }
+
+    blas = uint32_t(blases.size());
+    blases.push_back(scene);
+    blas_ids[&object] = blas;
+  }
+
+  if (blases[blas]->NumPrimitives() == 0) {
+    return;
+  }
+
+  uint32_t index = uint32_t(instances.blas.size());
+  instances.to_object.push_back(transform.to_object);
+  instances.blas.push_back(blas);
+
+  AddPrim(PrimType::INSTANCE , index , transform.BoxToWorld(blases[blas]->BoundingBox()));
+}
+
+void SceneCompiler::AddGeneric(const Hittable& object) {
+  uint32_t index = uint32_t(generics.object.size());
+  generics.object.push_back(&object);
+
+  AddPrim(PrimType::GENERIC , index , object.BoundingBox());
+}
+
+size_t SceneCompiler::NumPrimitives() const {
+  return prims.size();
+}
+
+uint32_t SceneCompiler::MaterialId(const Ref<Material>& mat) {
+  auto itr = material_ids.find(mat.get());
+  if (itr != material_ids.end()) {
+    return itr->second;
+  }
+
+  uint32_t id = uint32_t(materials.size());
+  materials.push_back(mat);
+  material_ids[mat.get()] = id;
+  return id;
+}
+
+void SceneCompiler::AddPrim(PrimType type , uint32_t index , const Aabb& bounds) {
+  prims.push_back({ type , index });
+  prim_bounds.push_back(bounds);
+}
+
+CompiledScene::CompiledScene(const Hittable& root , const BvhBuildOptions& options)
+    : root(&root) {
+  Build(options);
+}
+
+CompiledScene::CompiledScene(const Ref<Hittable>& root , const BvhBuildOptions& options)
+    : root(root.get()) , owned_root(root) {
+  Build(options);
+}
+
+void CompiledScene::Build(const BvhBuildOptions& options) {
+  SceneCompiler compiler(options);
+  root->Compile(compiler);
+
+  materials = std::move(compiler.materials);
+  blases = std::move(compiler.blases);
+
+  bbox = Aabb::empty;
+  for (const auto& bounds : compiler.prim_bounds) {
+    bbox = Aabb(bbox , bounds);
+  }
+
+  FlatBvh bvh = BvhBuilder(compiler.prim_bounds , options).Build();
+  stats = std::move(bvh.stats);
+
+  /// re-emit the primitives in leaf order , grouped by type inside each leaf , so every
+  ///   leaf becomes a handful of runs over contiguous array ranges
+  std::vector<uint32_t> leaf_prims;
+  for (LinearBvhNode& node : bvh.nodes) {
+    if (!node.IsLeaf()) {
+      continue;
+    }
+
+    leaf_prims.assign(bvh.prim_indices.begin() + node.offset , bvh.prim_indices.begin() + node.offset + node.prim_count);
+    std::stable_sort(leaf_prims.begin() , leaf_prims.end() , [&compiler](uint32_t a , uint32_t b) {
+      return compiler.prims[a].type < compiler.prims[b].type;
+    });
+
+    uint32_t first_run = uint32_t(runs.size());
+    for (uint32_t prim : leaf_prims) {
+      PrimType type = compiler.prims[prim].type;
+      uint32_t dst = EmitPrim(compiler , prim);
+      prim_order.push_back(prim);
+
+      if (runs.size() > first_run && runs.back().type == type) {
+        runs.back().count++;
+      } else {
+        runs.push_back({ type , dst , 1 });
+      }
+    }
+
+    node.offset = first_run;
+    node.prim_count = uint16_t(runs.size() - first_run);
+  }
+
+  nodes = CollapseBvh<width>(bvh.nodes);
+}
+
+Ref<CompiledScene> CompiledScene::Load(const Hittable& root , SceneCacheReader& reader) {
+  Ref<CompiledScene> scene(new CompiledScene());
+  scene->root = &root;
+
+  SceneCompiler compiler(BvhBuildOptions() , &reader);
+  root.Compile(compiler);
+
+  if (!scene->Restore(compiler , reader)) {
+    return nullptr;
+  }
+
+  return scene;
+}
+
+Ref<CompiledScene> CompiledScene::Load(const Ref<Hittable>& root , SceneCacheReader& reader) {
+  Ref<CompiledScene> scene = Load(*root , reader);
+  if (scene != nullptr) {
+    scene->owned_root = root;
+  }
+
+  return scene;
+}
+
+void CompiledScene::Save(SceneCacheWriter& writer) const {
+  for (const auto& blas : blases) {
+    blas->Save(writer);
+  }
+
+  writer.WriteArray(prim_order);
+  writer.WriteArray(runs);
+  writer.WriteArray(nodes);
+  writer.Write(bbox);
+}
+
+bool CompiledScene::Restore(const SceneCompiler& compiler , SceneCacheReader& reader) {
+  materials = compiler.materials;
+  blases = compiler.blases;
+
+  if (!reader.ReadArray(prim_order) || !reader.ReadArray(runs) || !reader.ReadArray(nodes) || !reader.Read(bbox)) {
+    return false;
+  }
+
+  if (prim_order.size() != compiler.prims.size()) {
+    reader.Invalidate();
+    return false;
+  }
+
+  for (uint32_t prim : prim_order) {
+    if (prim >= compiler.prims.size()) {
+      reader.Invalidate();
+      return false;
+    }
+
+    EmitPrim(compiler , prim);
+  }
+
+  /// a cache written for this graph can't fail these , they keep a damaged one from
+  ///   indexing out of bounds during traversal
+  for (const PrimRun& run : runs) {
+    if (size_t(run.first) + run.count > NumPrimitives(run.type)) {
+      reader.Invalidate();
+      return false;
+    }
+  }
+
+  for (const auto& node : nodes) {
+    for (uint32_t c = 0; c < width; ++c) {
+      bool in_bounds = (node.prim_count[c] > 0) ?
+        size_t(node.child[c]) + node.prim_count[c] <= runs.size() : node.child[c] < nodes.size();
+      if (!in_bounds) {
+        reader.Invalidate();
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+uint32_t CompiledScene::EmitPrim(const SceneCompiler& compiler , uint32_t prim) {
+  const SceneCompiler::PrimRef& ref = compiler.prims[prim];
+
+  uint32_t dst = 0;
+  switch (ref.type) {
+    case PrimType::SPHERE:
+      dst = uint32_t(spheres.radius.size());
+      spheres.Append(compiler.spheres , ref.index);
+      break;
+    case PrimType::MOVING_SPHERE:
+      dst = uint32_t(moving_spheres.radius.size());
+      moving_spheres.Append(compiler.moving_spheres , ref.index);
+      break;
+    case PrimType::QUAD:
+      dst = uint32_t(quads.d.size());
+      quads.Append(compiler.quads , ref.index);
+      break;
+    case PrimType::MEDIUM:
+      dst = uint32_t(media.boundary.size());
+      media.Append(compiler.media , ref.index);
+      break;
+    case PrimType::INSTANCE:
+      dst = uint32_t(instances.blas.size());
+      instances.Append(compiler.instances , ref.index);
+      break;
+    case PrimType::GENERIC:
+      dst = uint32_t(generics.object.size());
+      generics.Append(compiler.generics , ref.index);
+      break;
+  }
+
+  return dst;
+}
+
+bool CompiledScene::Hit(const Ray& r , Interval rayt , HitRecord& rec) const {
+  HitCandidate closest;
+
+  bool hit_anything = TraverseWideBvh<width>(nodes , r , rayt , [this , &r , &rec , &closest](uint32_t first , uint32_t count , Interval& ray_t) {
+    bool hit = false;
+    for (uint32_t i = first; i < first + count; ++i) {
+      const PrimRun& run = runs[i];
+      switch (run.type) {
+        case PrimType::SPHERE:
+          hit |= HitSpheres(run.first , run.count , r , ray_t , closest);
+          break;
+        case PrimType::MOVING_SPHERE:
+          hit |= HitMovingSpheres(run.first , run.count , r , ray_t , closest);
+          break;
+        case PrimType::QUAD:
+          hit |= HitQuads(run.first , run.count , r , ray_t , closest);
+          break;
+        case PrimType::MEDIUM:
+          hit |= HitMedia(run.first , run.count , r , ray_t , closest , rec);
+          break;
+        case PrimType::INSTANCE:
+          hit |= HitInstances(run.first , run.count , r , ray_t , closest , rec);
+          break;
+        case PrimType::GENERIC:
+          hit |= HitGenerics(run.first , run.count , r , ray_t , closest , rec);
+          break;
+      }
+    }
+    return hit;
+  });
+
+  if (!hit_anything) {
+    return false;
+  }
+
+  FinalizeHit(r , rayt.max , closest , rec);
+  return true;
+}
+
+Aabb CompiledScene::BoundingBox() const {
+  return bbox;
+}
+
+double CompiledScene::PdfValue(const Point3& origin , const glm::vec3& direction , double time) const {
+  return root->PdfValue(origin , direction , time);
+}
+
+glm::vec3 CompiledScene::Random(const Point3& origin , double time) const {
+  return root->Random(origin , time);
+}
+
+void CompiledScene::CollectLights(LightCollector& collector) const {
+  root->CollectLights(collector);
+}
+
+size_t CompiledScene::NumPrimitives() const {
+  return spheres.radius.size() + moving_spheres.radius.size() + quads.d.size() +
+         media.boundary.size() + instances.blas.size() + generics.object.size();
+}
+
+size_t CompiledScene::NumPrimitives(PrimType type) const {
+  switch (type) {
+    case PrimType::SPHERE: return spheres.radius.size();
+    case PrimType::MOVING_SPHERE: return moving_spheres.radius.size();
+    case PrimType::QUAD: return quads.d.size();
+    case PrimType::MEDIUM: return media.boundary.size();
+    case PrimType::INSTANCE: return instances.blas.size();
+    case PrimType::GENERIC: return generics.object.size();
+  }
+  return 0;
+}
+
+const BvhBuildStats& CompiledScene::BuildStats() const {
+  return stats;
+}
+
+void CompiledScene::PrintSummary() const {
+  std::cout << "Compiled scene : " << spheres.radius.size() << " spheres , "
+            << moving_spheres.radius.size() << " moving spheres , "
+            << quads.d.size() << " quads , "
+            << media.boundary.size() << " media , "
+            << instances.blas.size() << " instances of " << blases.size() << " blas , "
+            << generics.object.size() << " generic\n"
+            << "  " << materials.size() << " materials , " << runs.size() << " leaf runs , "
+            << nodes.size() << " nodes (" << width << " wide)\n";
+}
+
+bool CompiledScene::HitSpheres(uint32_t first , uint32_t count , const Ray& r , Interval& rayt , HitCandidate& closest) const {
+  RT_STATS(ThreadStats().AddPrimTests(StatPrim::SPHERE , count);)
+
+  const Point3& origin = r.Origin();
+  const glm::vec3& dir = r.Direction();
+  const double a = glm::dot(dir , dir);
+
+  bool hit_anything = false;
+  for (uint32_t i = first; i < first + count; ++i) {
+    glm::vec3 oc(spheres.center_x[i] - origin.x , spheres.center_y[i] - origin.y , spheres.center_z[i] - origin.z);
+    double radius = spheres.radius[i];
+
+    double h = glm::dot(dir , oc);
+    double c = glm::dot(oc , oc) - radius * radius;
+    double discriminant = h * h - a * c;
+
+    if (discriminant < 0) {
+      continue;
+    }
+
+    double sqrtd = glm::sqrt(discriminant);
+
+    double root = (h - sqrtd) / a;
+    if (!rayt.OpenContains(root)) {
+      root = (h + sqrtd) / a;
+      if (!rayt.OpenContains(root)) {
+        continue;
+      }
+    }
+
+    rayt.max = root;
+    closest.type = PrimType::SPHERE;
+    closest.index = i;
+    hit_anything = true;
+  }
+
+  return hit_anything;
+}
+
+bool CompiledScene::HitMovingSpheres(uint32_t first , uint32_t count , const Ray& r , Interval& rayt , HitCandidate& closest) const {
+  RT_STATS(ThreadStats().AddPrimTests(StatPrim::MOVING_SPHERE , count);)
+
+  const Point3& origin = r.Origin();
+  const glm::vec3& dir = r.Direction();
+  const double a = glm::dot(dir , dir);
+  const double time = r.Time();
+
+  bool hit_anything = false;
+  for (uint32_t i = first; i < first + count; ++i) {
+    Point3 center1(moving_spheres.center_x[i] , moving_spheres.center_y[i] , moving_spheres.center_z[i]);
+    glm::vec3 move(moving_spheres.move_x[i] , moving_spheres.move_y[i] , moving_spheres.move_z[i]);
+    Point3 center = center1 + time * move;
+    double radius = moving_spheres.radius[i];
+
+    glm::vec3 oc = center - origin;
+    double h = glm::dot(dir , oc);
+    double c = glm::dot(oc , oc) - radius * radius;
+    double discriminant = h * h - a * c;
+
+    if (discriminant < 0) {
+      continue;
+    }
+
+    double sqrtd = glm::sqrt(discriminant);
+
+    double root = (h - sqrtd) / a;
+    if (!rayt.OpenContains(root)) {
+      root = (h + sqrtd) / a;
+      if (!rayt.OpenContains(root)) {
+        continue;
+      }
+    }
+
+    rayt.max = root;
+    closest.type = PrimType::MOVING_SPHERE;
+    closest.index = i;
+    hit_anything = true;
+  }
+
+  return hit_anything;
+}
+
+bool CompiledScene::HitQuads(uint32_t first , uint32_t count , const Ray& r , Interval& rayt , HitCandidate& closest) const {
+  RT_STATS(ThreadStats().AddPrimTests(StatPrim::QUAD , count);)
+
+  const Point3& origin = r.Origin();
+  const glm::vec3& dir = r.Direction();
+
+  bool hit_anything = false;
+  for (uint32_t i = first; i < first + count; ++i) {
+    glm::vec3 normal(quads.normal_x[i] , quads.normal_y[i] , quads.normal_z[i]);
+
+    double denom = glm::dot(normal , dir);
+    if (std::fabs(denom) < 1e-8) {
+      continue;
+    }
+
+    double t = (quads.d[i] - glm::dot(normal , origin)) / denom;
+    if (!rayt.ClosedContains(t)) {
+      continue;
+    }
+
+    Point3 intersection = r.At(t);
+    glm::vec3 planar_hp_vec = intersection - Point3(quads.q_x[i] , quads.q_y[i] , quads.q_z[i]);
+    glm::vec3 u(quads.u_x[i] , quads.u_y[i] , quads.u_z[i]);
+    glm::vec3 v(quads.v_x[i] , quads.v_y[i] , quads.v_z[i]);
+    glm::vec3 w(quads.w_x[i] , quads.w_y[i] , quads.w_z[i]);
+
+    double alpha = glm::dot(w , glm::cross(planar_hp_vec , v));
+    double beta = glm::dot(w , glm::cross(u , planar_hp_vec));
+
+    /// written so NaNs fail like Interval::ClosedContains
+    if (!(alpha >= 0 && alpha <= 1 && beta >= 0 && beta <= 1)) {
+      continue;
+    }
+
+    rayt.max = t;
+    closest.type = PrimType::QUAD;
+    closest.index = i;
+    closest.u = alpha;
+    closest.v = beta;
+    hit_anything = true;
+  }
+
+  return hit_anything;
+}
+
+bool CompiledScene::HitMedia(uint32_t first , uint32_t count , const Ray& r , Interval& rayt , HitCandidate& closest , HitRecord& rec) const {
+  bool hit_anything = false;
+  for (uint32_t i = first; i < first + count; ++i) {
+    if (!ConstantMedium::HitVolume(*media.boundary[i] , media.neg_inv_density[i] , r , rayt , rec)) {
+      continue;
+    }
+
+    rayt.max = rec.t;
+    closest.type = PrimType::MEDIUM;
+    closest.index = i;
+    hit_anything = true;
+  }
+
+  return hit_anything;
+}
+
+bool CompiledScene::HitInstances(uint32_t first , uint32_t count , const Ray& r , Interval& rayt , HitCandidate& closest , HitRecord& rec) const {
+  RT_STATS(ThreadStats().AddPrimTests(StatPrim::INSTANCE , count);)
+
+  bool hit_anything = false;
+  for (uint32_t i = first; i < first + count; ++i) {
+    const glm::mat4x3& to_object = instances.to_object[i];
+
+    /// transformed once per instance entry. origin and direction go through the same affine
+    ///   map and the direction isn't renormalized , so a point at t maps to the point at t and
+    ///   t carries over even when a scale changes the length
+    Ray object_r(to_object * glm::vec4(r.Origin() , 1.0f) , glm::mat3(to_object) * r.Direction() , r.Time());
+
+    if (!blases[instances.blas[i]]->Hit(object_r , rayt , rec)) {
+      continue;
+    }
+
+    rayt.max = rec.t;
+    closest.type = PrimType::INSTANCE;
+    closest.index = i;
+    hit_anything = true;
+  }
+
+  return hit_anything;
+}
+
+bool CompiledScene::HitGenerics(uint32_t first , uint32_t count , const Ray& r , Interval& rayt , HitCandidate& closest , HitRecord& rec) const {
+  bool hit_anything = false;
+  for (uint32_t i = first; i < first + count; ++i) {
+    if (!generics.object[i]->Hit(r , rayt , rec)) {
+      continue;
+    }
+
+    rayt.max = rec.t;
+    closest.type = PrimType::GENERIC;
+    closest.index = i;
+    hit_anything = true;
+  }
+
+  return hit_anything;
+}
+
+void CompiledScene::FinalizeHit(const Ray& r , double t , const HitCandidate& closest , HitRecord& rec) const {
+  const uint32_t i = closest.index;
+
+  switch (closest.type) {
+    case PrimType::SPHERE: {
+      Point3 center(spheres.center_x[i] , spheres.center_y[i] , spheres.center_z[i]);
+
+      rec.t = t;
+      rec.point = r.At(t);
+
+      glm::vec3 outward_normal = (rec.point - center) / double(spheres.radius[i]);
+      rec.SetFaceNormal(r , outward_normal);
+      Sphere::GetSphereUV(outward_normal , rec.u , rec.v);
+
+      rec.mat = materials[spheres.material[i]].get();
+    } break;
+
+    case PrimType::MOVING_SPHERE: {
+      Point3 center1(moving_spheres.center_x[i] , moving_spheres.center_y[i] , moving_spheres.center_z[i]);
+      glm::vec3 move(moving_spheres.move_x[i] , moving_spheres.move_y[i] , moving_spheres.move_z[i]);
+      Point3 center = center1 + r.Time() * move;
+
+      rec.t = t;
+      rec.point = r.At(t);
+
+      glm::vec3 outward_normal = (rec.point - center) / double(moving_spheres.radius[i]);
+      rec.SetFaceNormal(r , outward_normal);
+      Sphere::GetSphereUV(outward_normal , rec.u , rec.v);
+
+      rec.mat = materials[moving_spheres.material[i]].get();
+    } break;
+
+    case PrimType::QUAD: {
+      rec.t = t;
+      rec.point = r.At(t);
+      rec.u = closest.u;
+      rec.v = closest.v;
+      rec.SetFaceNormal(r , glm::vec3(quads.normal_x[i] , quads.normal_y[i] , quads.normal_z[i]));
+
+      rec.mat = materials[quads.material[i]].get();
+    } break;
+
+    /// rec was filled when the hit was found , only the phase function is missing
+    case PrimType::MEDIUM:
+      rec.mat = materials[media.material[i]].get();
+      break;
+
+    /// normals go back through the inverse transpose of the linear part
+    case PrimType::INSTANCE:
+      rec.point = r.At(t);
+      rec.normal = UnitVector(glm::transpose(glm::mat3(instances.to_object[i])) * rec.normal);
+      break;
+
+    case PrimType::GENERIC:
+      break;
+  }
+}
@@ -0,0 +1,248 @@
+/**
+ * \file compiled_scene.hpp
+ **/
+#ifndef COMPILED_SCENE_HPP
+#define COMPILED_SCENE_HPP
+
+#include <unordered_map>
+#include <vector>
+
+#include "defines.hpp"
+#include "bvh_builder.hpp"
+#include "hittable.hpp"
+#include "transform.hpp"
+#include "wide_bvh.hpp"
+
+class CompiledScene;
+class Material;
+class SceneCacheReader;
+class SceneCacheWriter;
+
+enum class PrimType : uint8_t {
+  SPHERE ,
+  MOVING_SPHERE ,
+  QUAD ,
+  MEDIUM ,
+  /// transformed reference to a shared bottom level CompiledScene
+  INSTANCE ,
+  /// anything without a dedicated kernel , hit through its vtable
+  GENERIC ,
+};
+
+/// structure of arrays per primitive type , element i of every array belongs to primitive i
+class SphereArrays {
+  public:
+    std::vector<float> center_x{} , center_y{} , center_z{};
+    std::vector<float> radius{};
+    std::vector<uint32_t> material{};
+
+    void Append(const SphereArrays& src , uint32_t i);
+};
+
+class MovingSphereArrays {
+  public:
+    /// center at time 0 and its displacement by time 1
+    std::vector<float> center_x{} , center_y{} , center_z{};
+    std::vector<float> move_x{} , move_y{} , move_z{};
+    std::vector<float> radius{};
+    std::vector<uint32_t> material{};
+
+    void Append(const MovingSphereArrays& src , uint32_t i);
+};
+
+class QuadArrays {
+  public:
+    std::vector<float> q_x{} , q_y{} , q_z{};
+    std::vector<float> u_x{} , u_y{} , u_z{};
+    std::vector<float> v_x{} , v_y{} , v_z{};
+    std::vector<float> normal_x{} , normal_y{} , normal_z{};
+    std::vector<float> w_x{} , w_y{} , w_z{};
+    std::vector<double> d{};
+    std::vector<uint32_t> material{};
+
+    void Append(const QuadArrays& src , uint32_t i);
+};
+
+class MediumArrays {
+  public:
+    std::vector<const Hittable*> boundary{};
+    std::vector<double> neg_inv_density{};
+    std::vector<uint32_t> material{};
+
+    void Append(const MediumArrays& src , uint32_t i);
+};
+
+class InstanceArrays {
+  public:
+    std::vector<glm::mat4x3> to_object{};
+    std::vector<uint32_t> blas{};
+
+    void Append(const InstanceArrays& src , uint32_t i);
+};
+
+class GenericArrays {
+  public:
+    std::vector<const Hittable*> object{};
+
+    void Append(const GenericArrays& src , uint32_t i);
+};
+
+/// collects primitives while a Hittable graph lowers itself through Hittable::Compile.
+///   nothing is copied out of the graph that the kernels don't need , generic entries and
+///   media boundaries point back into it so the graph has to outlive the compiled scene
+class SceneCompiler {
+  public:
+    /// with a reader bottom level scenes are restored from it instead of built
+    SceneCompiler(const BvhBuildOptions& options = BvhBuildOptions() , SceneCacheReader* reader = nullptr);
+
+    void AddSphere(const Point3& center , double radius , const Ref<Material>& mat);
+    void AddMovingSphere(const Point3& center1 , const glm::vec3& center_vec , double radius , const Ref<Material>& mat);
+    void AddQuad(const Point3& Q , const glm::vec3& u , const glm::vec3& v , const glm::vec3& normal ,
+                 const glm::vec3& w , double D , const Ref<Material>& mat);
+    void AddMedium(const Hittable& boundary , double neg_inv_density , const Ref<Material>& phase_function);
+    /// object is compiled into a bottom level scene the first time it is seen , later
+    ///   instances of the same object share it
+    void AddInstance(const Hittable& object , const Transform& transform);
+    void AddGeneric(const Hittable& object);
+
+    size_t NumPrimitives() const;
+
+  private:
+    friend class CompiledScene;
+
+    struct PrimRef {
+      PrimType type;
+      uint32_t index;
+    };
+
+    std::vector<PrimRef> prims{};
+    std::vector<Aabb> prim_bounds{};
+
+    SphereArrays spheres;
+    MovingSphereArrays moving_spheres;
+    QuadArrays quads;
+    MediumArrays media;
+    InstanceArrays instances;
+    GenericArrays generics;
+
+    std::vector<Ref<Material>> materials{};
+    std::unordered_map<const Material*, uint32_t> material_ids{};
+
+    BvhBuildOptions options;
+    SceneCacheReader* reader = nullptr;
+    std::vector<Ref<CompiledScene>> blases{};
+    std::unordered_map<const Hittable*, uint32_t> blas_ids{};
+
+    uint32_t MaterialId(const Ref<Material>& mat);
+    void AddPrim(PrimType type , uint32_t index , const Aabb& bounds);
+};
+
+/// flat , data oriented form of a Hittable graph. primitives are lowered into per type
+///   arrays and referenced from a wide bvh , every leaf holds runs of same typed primitives
+///   that are contiguous in their arrays so leaf tests loop over plain data instead of
+///   dispatching through the vtable per primitive. instances make this the top level of a
+///   two level structure , each one holds a transform and an index into blases
+class CompiledScene : public Hittable {
+  public:
+    /// root must outlive the compiled scene
+    CompiledScene(const Hittable& root , const BvhBuildOptions& options = BvhBuildOptions());
+
+    /// keeps root alive for as long as the compiled scene
+    CompiledScene(const Ref<Hittable>& root , const BvhBuildOptions& options = BvhBuildOptions());
+
+    /// restores what Save wrote for the same root without building any bvh. root is only
+    ///   walked to collect materials and the objects primitives point back to , null when
+    ///   the cache doesn't match it
+    static Ref<CompiledScene> Load(const Hittable& root , SceneCacheReader& reader);
+    static Ref<CompiledScene> Load(const Ref<Hittable>& root , SceneCacheReader& reader);
+
+    /// bottom level scenes first , in the order Load meets them
+    void Save(SceneCacheWriter& writer) const;
+
+    virtual bool Hit(const Ray& r , Interval rayt , HitRecord& rec) const override;
+
+    virtual Aabb BoundingBox() const override;
+
+    virtual double PdfValue(const Point3& origin , const glm::vec3& direction , double time) const override;
+
+    virtual glm::vec3 Random(const Point3& origin , double time) const override;
+
+    /// lights are collected from the source graph
+    virtual void CollectLights(LightCollector& collector) const override;
+
+    size_t NumPrimitives() const;
+    size_t NumPrimitives(PrimType type) const;
+
+    const BvhBuildStats& BuildStats() const;
+
+    void PrintSummary() const;
+
+  private:
+    static constexpr uint32_t width = WideBvh::default_width;
+
+    /// leaf ranges of the bvh index into runs
+    struct PrimRun {
+      PrimType type;
+      uint32_t first;
+      uint32_t count;
+    };
+
+    /// closest primitive found so far. traversal only tracks this , the surface attributes
+    ///   are computed once for the final hit by FinalizeHit
+    struct HitCandidate {
+      PrimType type = PrimType::GENERIC;
+      uint32_t index = 0;
+      /// quad coordinates fall out of the inside test , kept so they aren't recomputed
+      double u = 0.0;
+      double v = 0.0;
+    };
+
+    const Hittable* root = nullptr;
+    Ref<Hittable> owned_root = nullptr;
+
+    /// index of every primitive into the compiler output , in leaf order. all a cache needs
+    ///   to re-emit the arrays from a fresh walk of root
+    std::vector<uint32_t> prim_order{};
+
+    std::vector<WideBvhNode<width>> nodes{};
+    std::vector<PrimRun> runs{};
+
+    SphereArrays spheres;
+    MovingSphereArrays moving_spheres;
+    QuadArrays quads;
+    MediumArrays media;
+    InstanceArrays instances;
+    GenericArrays generics;
+
+    std::vector<Ref<Material>> materials{};
+
+    /// bottom level scenes shared by the instances
+    std::vector<Ref<CompiledScene>> blases{};
+
+    Aabb bbox;
+
+    BvhBuildStats stats;
+
+    CompiledScene() {}
+
+    void Build(const BvhBuildOptions& options);
+
+    bool Restore(const SceneCompiler& compiler , SceneCacheReader& reader);
+
+    /// appends primitive prim of compiler to the arrays and returns its index there
+    uint32_t EmitPrim(const SceneCompiler& compiler , uint32_t prim);
+
+    /// run kernels shrink rayt.max to the closest t and update closest. generic objects ,
+    ///   media and instances fill rec themselves as they have no deferred form , instance
+    ///   hits are left in object space until FinalizeHit
+    bool HitSpheres(uint32_t first , uint32_t count , const Ray& r , Interval& rayt , HitCandidate& closest) const;
+    bool HitMovingSpheres(uint32_t first , uint32_t count , const Ray& r , Interval& rayt , HitCandidate& closest) const;
+    bool HitQuads(uint32_t first , uint32_t count , const Ray& r , Interval& rayt , HitCandidate& closest) const;
+    bool HitMedia(uint32_t first , uint32_t count , const Ray& r , Interval& rayt , HitCandidate& closest , HitRecord& rec) const;
+    bool HitInstances(uint32_t first , uint32_t count , const Ray& r , Interval& rayt , HitCandidate& closest , HitRecord& rec) const;
+    bool HitGenerics(uint32_t first , uint32_t count , const Ray& r , Interval& rayt , HitCandidate& closest , HitRecord& rec) const;
+
+    void FinalizeHit(const Ray& r , double t , const HitCandidate& closest , HitRecord& rec) const;
+};
+
+#endif // !COMPILED_SCENE_HPP
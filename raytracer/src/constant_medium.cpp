@@ -6,19 +6,33 @@
 #include <iostream>
 
 #include "defines.hpp"
+#include "compiled_scene.hpp"
 #include "interval.hpp"
+#include "render_stats.hpp"
 
 bool ConstantMedium::Hit(const Ray& r , Interval rayt , HitRecord& rec) const {
+  if (!HitVolume(*boundary , neg_inv_density , r , rayt , rec)) {
+    return false;
+  }
+
+  rec.mat = phase_function.get();
+
+  return true;
+}
+
+bool ConstantMedium::HitVolume(const Hittable& boundary , double neg_inv_density , const Ray& r , Interval rayt , HitRecord& rec) {
+  RT_STATS(ThreadStats().AddPrimTests(StatPrim::MEDIUM , 1);)
+
   const bool enable_debug = false;
   const bool debugging = enable_debug && RandomDouble() < 0.00001;
 
   HitRecord rec1 , rec2;
 
-  if (!boundary->Hit(r , Interval::universe , rec1)) {
+  if (!boundary.Hit(r , Interval::universe , rec1)) {
     return false;
   }
 
-  if (!boundary->Hit(r , Interval(rec1.t + 0.0001 , infinity) , rec2)) {
+  if (!boundary.Hit(r , Interval(rec1.t + 0.0001 , infinity) , rec2)) {
     return false;
   }
 
@@ -62,7 +76,6 @@ bool ConstantMedium::Hit(const Ray& r , Interval rayt , HitRecord& rec) const {
   rec.normal = RandomUnitVector(); 
   rec.front_face = (RandomInt() % 2) == 0 ?
     true : false;
-  rec.mat = phase_function;
 
   return true;
 }
@@ -71,10 +84,14 @@ Aabb ConstantMedium::BoundingBox() const {
   return boundary->BoundingBox();
 }
 
-double ConstantMedium::PdfValue(const Point3& origin , const glm::vec3& direction) const {
-  return boundary->PdfValue(origin , direction);
+double ConstantMedium::PdfValue(const Point3& origin , const glm::vec3& direction , double time) const {
+  return boundary->PdfValue(origin , direction , time);
+}
+
+glm::vec3 ConstantMedium::Random(const Point3& origin , double time) const {
+  return boundary->Random(origin , time);
 }
 
-glm::vec3 ConstantMedium::Random(const Point3& origin) const {
-  return boundary->Random(origin);
+void ConstantMedium::Compile(SceneCompiler& compiler) const {
+  compiler.AddMedium(*boundary , neg_inv_density , phase_function);
 }
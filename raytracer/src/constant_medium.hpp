@@ -22,9 +22,14 @@ class ConstantMedium : public Hittable {
 
     virtual Aabb BoundingBox() const override;
     
-    virtual double PdfValue(const Point3& origin , const glm::vec3& direction) const override;
+    virtual double PdfValue(const Point3& origin , const glm::vec3& direction , double time) const override;
 
-    virtual glm::vec3 Random(const Point3& origin) const override;
+    virtual glm::vec3 Random(const Point3& origin , double time) const override;
+
+    virtual void Compile(SceneCompiler& compiler) const override;
+
+    /// samples a scattering distance inside boundary and fills everything but the material
+    static bool HitVolume(const Hittable& boundary , double neg_inv_density , const Ray& r , Interval rayt , HitRecord& rec);
 
   private:
     Ref<Hittable> boundary;
@@ -6,12 +6,13 @@
 
 #include <limits>
 #include <memory>
-#include <random>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
 #include <glm/gtx/scalar_multiplication.hpp>
 
+#include "rng.hpp"
+
 using Point3 = glm::vec3;
 using Color = glm::vec3;
 
@@ -41,27 +42,8 @@ constexpr double DegreesToRadians(double degrees) {
 template <typename T>
 concept real_t = std::is_same_v<float , T> || std::is_same_v<double , T>;
 
-template <real_t T>
-struct RandomRealGenerator {
-  std::random_device dev;
-  std::mt19937_64 mersenne;
-  std::uniform_real_distribution<T> dist;
-
-  RandomRealGenerator()
-    : mersenne(rand()) {}
-  RandomRealGenerator(double min , double max)
-    : mersenne(rand()) , dist(min , max) {}
-
-  T Next() {
-    return dist(mersenne);
-  }
-};
-
-static RandomRealGenerator<double> rng{};
-static RandomRealGenerator<double> rng_01(0 , 1);
-
 inline double RandomDouble() {
-  return rng_01.Next();
+  return ThreadRng().NextDouble();
 }
 
 inline double RandomDouble(double min , double max) {
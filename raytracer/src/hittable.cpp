@@ -4,7 +4,10 @@
 #include "hittable.hpp"
 
 #include "defines.hpp"
+#include "compiled_scene.hpp"
+#include "light_sampler.hpp"
 #include "material.hpp"
+#include "render_stats.hpp"
 
 void HitRecord::SetFaceNormal(const Ray& r , const glm::vec3& outward_normal) {
   front_face = glm::dot(r.Direction() , outward_normal) < 0;
@@ -12,113 +15,72 @@ void HitRecord::SetFaceNormal(const Ray& r , const glm::vec3& outward_normal) {
     outward_normal : -outward_normal;
 }
 
-Translate::Translate(Ref<Hittable> object , const glm::vec3& offset) 
-    : object(object) , offset(offset) {
-  bbox = object->BoundingBox() + offset;
+void Hittable::Compile(SceneCompiler& compiler) const {
+  compiler.AddGeneric(*this);
 }
 
-bool Translate::Hit(const Ray& r , Interval rayt , HitRecord& rec) const {
-  Ray offset_r(r.Origin() - offset , r.Direction() , r.Time());
+void Hittable::CollectLights(LightCollector&) const {}
 
-  if (!object->Hit(offset_r , rayt , rec)) {
+Instance::Instance(Ref<Hittable> object , const Transform& transform)
+    : object(object) , transform(transform) {
+  if (auto inner = std::dynamic_pointer_cast<Instance>(object)) {
+    this->object = inner->object;
+    this->transform = transform * inner->transform;
+  }
+
+  bbox = this->transform.BoxToWorld(this->object->BoundingBox());
+}
+
+bool Instance::Hit(const Ray& r , Interval rayt , HitRecord& rec) const {
+  RT_STATS(ThreadStats().AddPrimTests(StatPrim::INSTANCE , 1);)
+
+  /// the direction is not renormalized so t means the same in both spaces
+  Ray object_r(transform.PointToObject(r.Origin()) , transform.VectorToObject(r.Direction()) , r.Time());
+
+  if (!object->Hit(object_r , rayt , rec)) {
     return false;
   }
 
-  rec.point += offset;
+  rec.point = r.At(rec.t);
+  rec.normal = UnitVector(transform.NormalToWorld(rec.normal));
 
   return true;
 }
 
-Aabb Translate::BoundingBox() const {
+Aabb Instance::BoundingBox() const {
   return bbox;
 }
 
-double Translate::PdfValue(const Point3& origin , const glm::vec3& direction) const {
-  return object->PdfValue(origin , direction);
+double Instance::PdfValue(const Point3& origin , const glm::vec3& direction , double time) const {
+  double object_pdf = object->PdfValue(transform.PointToObject(origin) , transform.VectorToObject(direction) , time);
+  return (object_pdf > 0.0) ?
+    object_pdf * transform.DensityToWorld(direction) : 0.0;
 }
 
-glm::vec3 Translate::Random(const Point3& origin) const {
-  return object->Random(origin);
+glm::vec3 Instance::Random(const Point3& origin , double time) const {
+  return transform.VectorToWorld(object->Random(transform.PointToObject(origin) , time));
 }
 
-RotateY::RotateY(Ref<Hittable> object , double angle)
-    : object(object) , angle(angle) {
-  auto radians = DegreesToRadians(angle);
-
-  sin_theta = glm::sin(radians);
-  cos_theta = glm::cos(radians);
-
-  bbox = object->BoundingBox();
-
-  Point3 min(infinity , infinity , infinity);
-  Point3 max(-infinity , -infinity , -infinity);
-
-  for (int32_t i = 0; i < 2; ++i) {
-    for (int32_t j = 0; j < 2; ++j) {
-      for (int32_t k = 0; k < 2; ++k) {
-        auto x = i * bbox.x.max + (1 - i) * bbox.x.min;
-        auto y = j * bbox.y.max + (1 - j) * bbox.y.min;
-        auto z = k * bbox.z.max + (1 - k) * bbox.z.min;
-
-        auto newx = cos_theta * x + sin_theta * z;
-        auto newz = -sin_theta * x + cos_theta * z;
-
-        glm::vec3 tester(newx , y , newz);
-
-        min.x = fmin(min.x , tester.x);
-        max.x = fmax(max.x , tester.x);
-
-        min.y = fmin(min.y , tester.y);
-        max.y = fmax(max.y , tester.y);
-
-        min.z = fmin(min.z , tester.z);
-        max.z = fmax(max.z , tester.z);
-      }
-    }
-  }
-
-  bbox = Aabb(min , max);
+void Instance::Compile(SceneCompiler& compiler) const {
+  compiler.AddInstance(*object , transform);
 }
 
-bool RotateY::Hit(const Ray& r , Interval rayt , HitRecord& rec) const {
-  auto origin = r.Origin();
-  auto dir = r.Direction();
-
-  origin.x = cos_theta * r.Origin().x - sin_theta * r.Origin().z;
-  origin.z = sin_theta * r.Origin().x + cos_theta * r.Origin().z;
-
-  dir.x = cos_theta * r.Direction().x - sin_theta * r.Direction().z;
-  dir.z = sin_theta * r.Direction().x + cos_theta * r.Direction().z;
-
-  Ray rotated_r(origin , dir , r.Time());
-
-  if (!object->Hit(rotated_r , rayt , rec)) {
-    return false;
-  }
-
-  auto p = rec.point;
-
-  p.x = cos_theta * rec.point.x + sin_theta * rec.point.z;
-  p.z = -sin_theta * rec.point.x + cos_theta * rec.point.z;
-
-  auto normal = rec.normal;
-  normal.x = cos_theta * rec.normal.x + sin_theta * rec.normal.z;
-  normal.z = -sin_theta * rec.normal.x + cos_theta * rec.normal.z;
-
-  rec.point = p;
-  rec.normal = normal;
-
-  return true;
+void Instance::CollectLights(LightCollector& collector) const {
+  collector.PushTransform(transform);
+  object->CollectLights(collector);
+  collector.PopTransform();
 }
 
-Aabb RotateY::BoundingBox() const {
-  return bbox; 
+const Ref<Hittable>& Instance::Object() const {
+  return object;
 }
 
-double RotateY::PdfValue(const Point3& origin , const glm::vec3& direction) const {
-  return object->PdfValue(origin , direction);
+const Transform& Instance::GetTransform() const {
+  return transform;
 }
 
-glm::vec3 RotateY::Random(const Point3& origin) const {
-  return object->Random(origin);
-}
+Translate::Translate(Ref<Hittable> object , const glm::vec3& offset)
+    : Instance(object , Transform::Translate(offset)) {}
+
+RotateY::RotateY(Ref<Hittable> object , double angle)
+    : Instance(object , Transform::RotateY(angle)) {}
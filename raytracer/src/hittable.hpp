@@ -8,14 +8,18 @@
 #include "ray.hpp"
 #include "interval.hpp"
 #include "aabb.hpp"
+#include "transform.hpp"
 
+class LightCollector;
 class Material;
+class SceneCompiler;
 
 class HitRecord {
   public:
     Point3 point;
     glm::vec3 normal;
-    Ref<Material> mat;
+    /// owned by the scene , a plain pointer so recording a candidate hit costs no refcounting
+    const Material* mat = nullptr;
     double t;
     double u;
     double v;
@@ -32,53 +36,62 @@ class Hittable {
 
     virtual Aabb BoundingBox() const = 0;
 
-    virtual double PdfValue(const Point3& origin , const glm::vec3& direction) const = 0;
+    /// solid angle density of Random sending direction from origin , time is the time of the
+    ///   ray at origin so moving shapes are sampled where they are
+    virtual double PdfValue(const Point3& origin , const glm::vec3& direction , double time) const = 0;
 
-    virtual glm::vec3 Random(const Point3& origin) const = 0;
+    virtual glm::vec3 Random(const Point3& origin , double time) const = 0;
+
+    /// lowers this object into the flat per type arrays of a CompiledScene. types without
+    ///   a dedicated kernel keep the default and are added as generic entries
+    virtual void Compile(SceneCompiler& compiler) const;
+
+    /// reports emissive surfaces to the light sampler , containers forward to their children
+    virtual void CollectLights(LightCollector& collector) const;
 };
 
-class Translate : public Hittable {
+/// object placed in the world by an affine transform. the ray is moved into object space
+///   once per hit test and the hit moved back , nested instances are folded into a single
+///   transform on construction. lowers to an instance of a shared bottom level structure
+class Instance : public Hittable {
   public:
-    Translate(Ref<Hittable> object , const glm::vec3& offset);
+    Instance(Ref<Hittable> object , const Transform& transform);
 
-    virtual ~Translate() override {}
+    virtual ~Instance() override {}
 
     virtual bool Hit(const Ray& r , Interval rayt , HitRecord& rec) const override;
 
     virtual Aabb BoundingBox() const override;
-    
-    virtual double PdfValue(const Point3& origin , const glm::vec3& direction) const override;
 
-    virtual glm::vec3 Random(const Point3& origin) const override;
+    /// the object space density of the direction , scaled by the change of solid angle the
+    ///   transform makes so it stays exact under non uniform scale and shear
+    virtual double PdfValue(const Point3& origin , const glm::vec3& direction , double time) const override;
 
-  private:
-    Ref<Hittable> object;
-    glm::vec3 offset;
-    Aabb bbox;
-};
+    virtual glm::vec3 Random(const Point3& origin , double time) const override;
 
-class RotateY : public Hittable {
-  public:
-    RotateY(Ref<Hittable> object , double angle);
+    virtual void Compile(SceneCompiler& compiler) const override;
 
-    virtual ~RotateY() override {}
+    virtual void CollectLights(LightCollector& collector) const override;
 
-    virtual bool Hit(const Ray& r , Interval rayt , HitRecord& rec) const override;
+    const Ref<Hittable>& Object() const;
 
-    virtual Aabb BoundingBox() const override;
-    
-    virtual double PdfValue(const Point3& origin , const glm::vec3& direction) const override;
+    const Transform& GetTransform() const;
 
-    virtual glm::vec3 Random(const Point3& origin) const override;
-    
   private:
     Ref<Hittable> object;
-    double angle;
+    Transform transform;
+    Aabb bbox;
+};
 
-    double cos_theta;
-    double sin_theta;
+class Translate : public Instance {
+  public:
+    Translate(Ref<Hittable> object , const glm::vec3& offset);
+};
 
-    Aabb bbox;
+/// rotation about the y axis in degrees
+class RotateY : public Instance {
+  public:
+    RotateY(Ref<Hittable> object , double angle);
 };
 
 #endif // !HIT_TABLE_HPP
@@ -3,6 +3,9 @@
  **/
 #include "hittable_list.hpp"
 
+#include "compiled_scene.hpp"
+#include "light_sampler.hpp"
+
 HittableList::HittableList(Ref<Hittable> obj) {
   Add(obj);
 }
@@ -17,15 +20,15 @@ void HittableList::Add(Ref<Hittable> obj) {
 }
 
 bool HittableList::Hit(const Ray& r , Interval rayt , HitRecord& rec) const {
-  HitRecord temp_rec;
   bool hit_anything = false;
   auto closest_so_far = rayt.max;
 
+  /// hittables only write rec when they report a hit , and every later hit is closer ,
+  ///   so the record can be filled in place instead of copied on each improvement
   for (const auto& obj : objects) {
-    if (obj->Hit(r , Interval(rayt.min , closest_so_far) , temp_rec)) {
+    if (obj->Hit(r , Interval(rayt.min , closest_so_far) , rec)) {
       hit_anything = true;
-      closest_so_far = temp_rec.t;
-      rec = temp_rec;
+      closest_so_far = rec.t;
     }
   }
 
@@ -36,18 +39,30 @@ Aabb HittableList::BoundingBox() const {
   return bbox;
 }
 
-double HittableList::PdfValue(const Point3& origin , const glm::vec3& direction) const {
+double HittableList::PdfValue(const Point3& origin , const glm::vec3& direction , double time) const {
   auto weight = 1.0 / objects.size();
   auto sum = 0.0;
 
   for (const auto& obj : objects) {
-    sum += weight * obj->PdfValue(origin , direction);
+    sum += weight * obj->PdfValue(origin , direction , time);
   }
 
   return sum;
 }
 
-glm::vec3 HittableList::Random(const Point3& origin) const {
+glm::vec3 HittableList::Random(const Point3& origin , double time) const {
   auto int_size = int32_t(objects.size());
-  return objects[RandomInt(0 , int_size - 1)]->Random(origin);
+  return objects[RandomInt(0 , int_size - 1)]->Random(origin , time);
+}
+
+void HittableList::Compile(SceneCompiler& compiler) const {
+  for (const auto& obj : objects) {
+    obj->Compile(compiler);
+  }
+}
+
+void HittableList::CollectLights(LightCollector& collector) const {
+  for (const auto& obj : objects) {
+    obj->CollectLights(collector);
+  }
 }
@@ -0,0 +1,296 @@
+/**
+ * \file image_writer.cpp
+ **/
+#include "image_writer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb/stb_image_write.h>
+
+#include "interval.hpp"
+#include "thread_pool.hpp"
+
+/// rows per task of the parallel kernels
+static constexpr uint32_t rows_per_task = 16;
+
+static double LinearToGamma(double linear_component) {
+  if (linear_component > 0) {
+    return glm::sqrt(linear_component);
+  }
+
+  return 0;
+}
+
+static uint8_t QuantizeChannel(float c) {
+  if (c != c) {
+    c = 0.0f;
+  }
+
+  /// kept in float between the steps as the ascii writer did so the bytes don't change
+  c = float(LinearToGamma(c));
+
+  static const Interval intensity(0.000 , 0.999);
+  return uint8_t(256 * intensity.Clamp(c));
+}
+
+/// runs func over [first , last) row ranges , on the pool when there is one
+template <typename F>
+static void ForEachRowRange(uint32_t height , ThreadPool* pool , F&& func) {
+  size_t num_tasks = (size_t(height) + rows_per_task - 1) / rows_per_task;
+  if (pool == nullptr || num_tasks <= 1) {
+    func(0u , height);
+    return;
+  }
+
+  pool->ParallelFor(num_tasks , [height , &func](size_t task , uint32_t) {
+    uint32_t first = uint32_t(task) * rows_per_task;
+    func(first , std::min(first + rows_per_task , height));
+  });
+}
+
+static void AppendString(std::vector<uint8_t>& out , const std::string& str) {
+  out.insert(out.end() , str.begin() , str.end());
+}
+
+static void EncodePpmAscii(uint32_t width , uint32_t height , const std::vector<uint8_t>& rgb , std::vector<uint8_t>& out) {
+  AppendString(out , "P3\n" + std::to_string(width) + ' ' + std::to_string(height) + "\n255\n");
+
+  /// at most "255 255 255\n" per pixel
+  size_t header_size = out.size();
+  out.resize(header_size + rgb.size() / 3 * 12);
+
+  char* dst = reinterpret_cast<char*>(out.data() + header_size);
+  for (size_t i = 0; i < rgb.size(); i += 3) {
+    dst = std::to_chars(dst , dst + 3 , rgb[i]).ptr;
+    *dst++ = ' ';
+    dst = std::to_chars(dst , dst + 3 , rgb[i + 1]).ptr;
+    *dst++ = ' ';
+    dst = std::to_chars(dst , dst + 3 , rgb[i + 2]).ptr;
+    *dst++ = '\n';
+  }
+
+  out.resize(dst - reinterpret_cast<char*>(out.data()));
+}
+
+static std::string PpmHeader(uint32_t width , uint32_t height) {
+  return "P6\n" + std::to_string(width) + ' ' + std::to_string(height) + "\n255\n";
+}
+
+static std::string PfmHeader(uint32_t width , uint32_t height) {
+  /// the sign of the scale gives the byte order of the floats
+  const uint16_t probe = 1;
+  bool little_endian = *reinterpret_cast<const uint8_t*>(&probe) == 1;
+  return "PF\n" + std::to_string(width) + ' ' + std::to_string(height) + (little_endian ? "\n-1.0\n" : "\n1.0\n");
+}
+
+/// the header leaves the floats unaligned so they are copied in
+static void StorePfmPixel(uint8_t* dst , const Color& color) {
+  float rgb[3];
+  for (uint32_t c = 0; c < 3; ++c) {
+    rgb[c] = (color[c] != color[c]) ?
+      0.0f : color[c];
+  }
+  std::memcpy(dst , rgb , sizeof(rgb));
+}
+
+static void EncodePpm(uint32_t width , uint32_t height , const std::vector<uint8_t>& rgb , std::vector<uint8_t>& out) {
+  AppendString(out , PpmHeader(width , height));
+  out.insert(out.end() , rgb.begin() , rgb.end());
+}
+
+static void AppendToVector(void* context , void* data , int size) {
+  auto out = static_cast<std::vector<uint8_t>*>(context);
+  auto bytes = static_cast<const uint8_t*>(data);
+  out->insert(out->end() , bytes , bytes + size);
+}
+
+static bool EncodePng(uint32_t width , uint32_t height , const std::vector<uint8_t>& rgb , std::vector<uint8_t>& out) {
+  return stbi_write_png_to_func(AppendToVector , &out , int(width) , int(height) , 3 , rgb.data() , int(width) * 3) != 0;
+}
+
+static void EncodePfm(uint32_t width , uint32_t height , const std::vector<Color>& pixels , std::vector<uint8_t>& out , ThreadPool* pool) {
+  AppendString(out , PfmHeader(width , height));
+
+  size_t header_size = out.size();
+  size_t row_bytes = size_t(width) * 3 * sizeof(float);
+  out.resize(header_size + row_bytes * height);
+
+  /// scanlines are stored bottom to top
+  uint8_t* data = out.data() + header_size;
+  ForEachRowRange(height , pool , [&](uint32_t first , uint32_t last) {
+    for (uint32_t y = first; y < last; ++y) {
+      uint8_t* dst = data + size_t(height - 1 - y) * row_bytes;
+      const Color* src = pixels.data() + size_t(y) * width;
+      for (uint32_t x = 0; x < width; ++x) {
+        StorePfmPixel(dst + x * 3 * sizeof(float) , src[x]);
+      }
+    }
+  });
+}
+
+ImageFormat FormatFromFileName(const std::string& file_name) {
+  size_t dot = file_name.find_last_of('.');
+  if (dot == std::string::npos) {
+    return ImageFormat::PPM;
+  }
+
+  std::string ext = file_name.substr(dot + 1);
+  std::transform(ext.begin() , ext.end() , ext.begin() , [](unsigned char c) { return char(std::tolower(c)); });
+
+  if (ext == "png") {
+    return ImageFormat::PNG;
+  } else if (ext == "pfm") {
+    return ImageFormat::PFM;
+  }
+
+  return ImageFormat::PPM;
+}
+
+void QuantizeImage(const std::vector<Color>& pixels , std::vector<uint8_t>& rgb , ThreadPool* pool) {
+  rgb.resize(pixels.size() * 3);
+
+  /// the kernel is per pixel so the image is split into runs of a fixed length rather
+  ///   than its own rows
+  const uint32_t width = 1024;
+  uint32_t height = uint32_t((pixels.size() + width - 1) / width);
+
+  ForEachRowRange(height , pool , [&](uint32_t first , uint32_t last) {
+    size_t end = std::min(size_t(last) * width , pixels.size());
+    for (size_t i = size_t(first) * width; i < end; ++i) {
+      rgb[3 * i + 0] = QuantizeChannel(pixels[i].x);
+      rgb[3 * i + 1] = QuantizeChannel(pixels[i].y);
+      rgb[3 * i + 2] = QuantizeChannel(pixels[i].z);
+    }
+  });
+}
+
+bool EncodeImage(ImageFormat format , uint32_t width , uint32_t height , const std::vector<Color>& pixels ,
+                 std::vector<uint8_t>& file_data , ThreadPool* pool) {
+  file_data.clear();
+  if (pixels.size() != size_t(width) * height) {
+    std::cerr << "ERROR : Image size doesn't match its pixel count : " << width << "x" << height << "\n";
+    return false;
+  }
+
+  if (format == ImageFormat::PFM) {
+    EncodePfm(width , height , pixels , file_data , pool);
+    return true;
+  }
+
+  std::vector<uint8_t> rgb;
+  QuantizeImage(pixels , rgb , pool);
+
+  switch (format) {
+    case ImageFormat::PPM_ASCII:
+      EncodePpmAscii(width , height , rgb , file_data);
+      return true;
+
+    case ImageFormat::PNG:
+      return EncodePng(width , height , rgb , file_data);
+
+    default:
+      EncodePpm(width , height , rgb , file_data);
+      return true;
+  }
+}
+
+bool WriteFileData(const std::string& file_name , const std::vector<uint8_t>& file_data) {
+  return WriteFileAtomic(file_name , { { file_data.data() , file_data.size() } } , "image file");
+}
+
+bool WriteImage(const std::string& file_name , ImageFormat format , uint32_t width , uint32_t height ,
+                const std::vector<Color>& pixels , ThreadPool* pool) {
+  if (format == ImageFormat::AUTO) {
+    format = FormatFromFileName(file_name);
+  }
+
+  std::vector<uint8_t> file_data;
+  return EncodeImage(format , width , height , pixels , file_data , pool) &&
+    WriteFileData(file_name , file_data);
+}
+
+bool MappedImage::Supports(ImageFormat format) {
+  return format == ImageFormat::PPM || format == ImageFormat::PFM;
+}
+
+bool MappedImage::Create(const std::string& file_name , ImageFormat format , uint32_t width , uint32_t height) {
+  Close();
+
+  if (format == ImageFormat::AUTO) {
+    format = FormatFromFileName(file_name);
+  }
+
+  if (!Supports(format) || width == 0 || height == 0) {
+    std::cerr << "ERROR : Image format can't be written in place : " << file_name << "\n";
+    return false;
+  }
+
+  std::string header = (format == ImageFormat::PFM) ?
+    PfmHeader(width , height) : PpmHeader(width , height);
+  size_t pixel_size = (format == ImageFormat::PFM) ?
+    3 * sizeof(float) : 3;
+
+  if (!file.Create(file_name , header.size() + size_t(width) * height * pixel_size)) {
+    std::cerr << "ERROR : Failed to create image file : " << file_name << "\n";
+    return false;
+  }
+
+  std::copy(header.begin() , header.end() , file.MutableData());
+
+  this->format = format;
+  this->width = width;
+  this->height = height;
+  header_size = header.size();
+  return true;
+}
+
+void MappedImage::WriteRect(uint32_t x0 , uint32_t y0 , uint32_t w , uint32_t h , const Color* pixels) {
+  uint8_t* data = file.MutableData();
+  if (data == nullptr) {
+    return;
+  }
+
+  data += header_size;
+  for (uint32_t y = 0; y < h; ++y) {
+    const Color* src = pixels + size_t(y) * w;
+
+    if (format == ImageFormat::PFM) {
+      /// scanlines are stored bottom to top
+      uint8_t* dst = data + (size_t(height - 1 - (y0 + y)) * width + x0) * 3 * sizeof(float);
+      for (uint32_t x = 0; x < w; ++x) {
+        StorePfmPixel(dst + x * 3 * sizeof(float) , src[x]);
+      }
+    } else {
+      uint8_t* dst = data + (size_t(y0 + y) * width + x0) * 3;
+      for (uint32_t x = 0; x < w; ++x) {
+        dst[3 * x + 0] = QuantizeChannel(src[x].x);
+        dst[3 * x + 1] = QuantizeChannel(src[x].y);
+        dst[3 * x + 2] = QuantizeChannel(src[x].z);
+      }
+    }
+  }
+}
+
+bool MappedImage::Flush() {
+  return file.Flush();
+}
+
+void MappedImage::Close() {
+  file.Close();
+  width = 0;
+  height = 0;
+  header_size = 0;
+}
+
+bool MappedImage::IsOpen() const {
+  return file.IsOpen();
+}
+
+size_t MappedImage::FileSize() const {
+  return file.Size();
+}
@@ -0,0 +1,78 @@
+/**
+ * \file image_writer.hpp
+ **/
+#ifndef IMAGE_WRITER_HPP
+#define IMAGE_WRITER_HPP
+
+#include <string>
+#include <vector>
+
+#include "defines.hpp"
+#include "mapped_file.hpp"
+
+class ThreadPool;
+
+enum class ImageFormat {
+  /// picked from the extension of the file name
+  AUTO ,
+  /// ascii P3 , the original output of the camera
+  PPM_ASCII ,
+  /// binary P6 , same pixel values as PPM_ASCII
+  PPM ,
+  PNG ,
+  /// little endian float rgb , linear radiance with no tone mapping or clamping
+  PFM ,
+};
+
+/// .png and .pfm map to their formats , anything else is written as binary ppm
+ImageFormat FormatFromFileName(const std::string& file_name);
+
+/// gamma 2 and 8 bit quantization of linear radiance , nan channels go to 0. rows are
+///   split across pool when one is given
+void QuantizeImage(const std::vector<Color>& pixels , std::vector<uint8_t>& rgb , ThreadPool* pool = nullptr);
+
+/// encodes pixels , row major from the top left , into the bytes of a complete file
+bool EncodeImage(ImageFormat format , uint32_t width , uint32_t height , const std::vector<Color>& pixels ,
+                 std::vector<uint8_t>& file_data , ThreadPool* pool = nullptr);
+
+/// through WriteFileAtomic , a progressive render rewrites its image under readers
+bool WriteFileData(const std::string& file_name , const std::vector<uint8_t>& file_data);
+
+/// EncodeImage followed by WriteFileData , AUTO is resolved against file_name
+bool WriteImage(const std::string& file_name , ImageFormat format , uint32_t width , uint32_t height ,
+                const std::vector<Color>& pixels , ThreadPool* pool = nullptr);
+
+/// output file mapped into memory and filled a rectangle at a time , a frame streamed
+///   through it is never held in memory as a whole and what has been written so far can
+///   be looked at while the rest renders. pixels not written yet read as black
+class MappedImage {
+  public:
+    MappedImage() {}
+
+    /// P6 and PFM have a fixed layout that can be filled in any order
+    static bool Supports(ImageFormat format);
+
+    /// AUTO is resolved against file_name
+    bool Create(const std::string& file_name , ImageFormat format , uint32_t width , uint32_t height);
+
+    /// pixels holds w x h colors row major , encoded the same way EncodeImage does. calls
+    ///   for disjoint rectangles may run concurrently
+    void WriteRect(uint32_t x0 , uint32_t y0 , uint32_t w , uint32_t h , const Color* pixels);
+
+    bool Flush();
+
+    void Close();
+
+    bool IsOpen() const;
+
+    size_t FileSize() const;
+
+  private:
+    MappedFile file;
+    ImageFormat format = ImageFormat::PPM;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t header_size = 0;
+};
+
+#endif // !IMAGE_WRITER_HPP
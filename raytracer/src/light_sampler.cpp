@@ -0,0 +1,360 @@
+/**
+ * \file light_sampler.cpp
+ **/
+#include "light_sampler.hpp"
+
+#include <algorithm>
+
+#include "linear_bvh.hpp"
+#include "material.hpp"
+
+void LightCollector::AddLight(const Hittable& shape , const Material* mat , double area) {
+  double radiance = 1.0;
+  if (require_emission) {
+    if (mat == nullptr) {
+      return;
+    }
+
+    Color emission = mat->AverageEmission();
+    radiance = (double(emission.x) + emission.y + emission.z) / 3.0;
+  }
+
+  int32_t transform = transform_stack.empty() ?
+    -1 : transform_stack.back();
+
+  Aabb bounds = shape.BoundingBox();
+  if (transform >= 0) {
+    const Transform& t = transforms[transform];
+    bounds = t.BoxToWorld(bounds);
+
+    /// areas scale with the square of the average linear scale factor
+    double det = std::fabs(glm::determinant(glm::mat3(t.to_world)));
+    area *= std::pow(det , 2.0 / 3.0);
+  }
+
+  double power = pi * radiance * area;
+  if (!(power > 0.0)) {
+    return;
+  }
+
+  lights.push_back({ &shape , transform , power , bounds });
+}
+
+void LightCollector::PushTransform(const Transform& transform) {
+  int32_t parent = transform_stack.empty() ?
+    -1 : transform_stack.back();
+
+  transforms.push_back(parent < 0 ? transform : transforms[parent] * transform);
+  transform_stack.push_back(int32_t(transforms.size() - 1));
+}
+
+void LightCollector::PopTransform() {
+  transform_stack.pop_back();
+}
+
+LightSampler::LightSampler(const Hittable& scene , LightSampling strategy , bool require_emission)
+    : strategy(strategy) {
+  LightCollector collector;
+  collector.require_emission = require_emission;
+  scene.CollectLights(collector);
+
+  lights = std::move(collector.lights);
+  transforms = std::move(collector.transforms);
+
+  BuildBvh();
+  BuildAliasTable();
+}
+
+bool LightSampler::Hit(const Ray& r , Interval rayt , HitRecord& rec) const {
+  return TraverseLinearBvh(nodes , r , rayt , [this , &r , &rec](uint32_t first , uint32_t count , Interval& ray_t) {
+    bool hit = false;
+    for (uint32_t i = first; i < first + count; ++i) {
+      const LightCollector::Entry& light = lights[i];
+
+      bool light_hit = false;
+      if (light.transform < 0) {
+        light_hit = light.shape->Hit(r , ray_t , rec);
+      } else {
+        const Transform& t = transforms[light.transform];
+        Ray object_r(t.PointToObject(r.Origin()) , t.VectorToObject(r.Direction()) , r.Time());
+
+        light_hit = light.shape->Hit(object_r , ray_t , rec);
+        if (light_hit) {
+          rec.point = r.At(rec.t);
+          rec.normal = UnitVector(t.NormalToWorld(rec.normal));
+        }
+      }
+
+      if (light_hit) {
+        ray_t.max = rec.t;
+        hit = true;
+      }
+    }
+    return hit;
+  });
+}
+
+Aabb LightSampler::BoundingBox() const {
+  return bbox;
+}
+
+double LightSampler::PdfValue(const Point3& origin , const glm::vec3& direction , double time) const {
+  if (lights.empty()) {
+    return 0.0;
+  }
+
+  /// only lights whose bounds the direction passes through can have a non zero pdf
+  double sum = 0.0;
+  Interval rayt(0.001 , infinity);
+  TraverseLinearBvh(nodes , Ray(origin , direction , time) , rayt , [this , &origin , &direction , time , &sum](uint32_t first , uint32_t count , Interval&) {
+    for (uint32_t i = first; i < first + count; ++i) {
+      double pdf = LightPdfValue(i , origin , direction , time);
+      if (pdf > 0.0) {
+        sum += LightPmf(origin , i) * pdf;
+      }
+    }
+    return false;
+  });
+
+  return sum;
+}
+
+glm::vec3 LightSampler::Random(const Point3& origin , double time) const {
+  if (lights.empty()) {
+    return glm::vec3(1 , 0 , 0);
+  }
+
+  double pmf = 0.0;
+  const LightCollector::Entry& light = lights[SampleLight(origin , RandomDouble() , pmf)];
+
+  if (light.transform < 0) {
+    return light.shape->Random(origin , time);
+  }
+
+  const Transform& t = transforms[light.transform];
+  return t.VectorToWorld(light.shape->Random(t.PointToObject(origin) , time));
+}
+
+bool LightSampler::Empty() const {
+  return lights.empty();
+}
+
+size_t LightSampler::NumLights() const {
+  return lights.size();
+}
+
+uint32_t LightSampler::SampleLight(const Point3& p , double u , double& pmf) const {
+  const uint32_t num_lights = uint32_t(lights.size());
+
+  switch (strategy) {
+    case LightSampling::UNIFORM: {
+      pmf = 1.0 / num_lights;
+      return std::min(uint32_t(u * num_lights) , num_lights - 1);
+    }
+
+    case LightSampling::POWER: {
+      double scaled = u * num_lights;
+      uint32_t i = std::min(uint32_t(scaled) , num_lights - 1);
+      uint32_t light = (scaled - i < alias_prob[i]) ?
+        i : alias[i];
+      pmf = lights[light].power / total_power;
+      return light;
+    }
+
+    case LightSampling::BVH:
+      break;
+  }
+
+  /// u is rescaled at every decision so one number drives the whole descent
+  pmf = 1.0;
+  uint32_t node = 0;
+  while (!nodes[node].IsLeaf()) {
+    uint32_t c0 = node + 1;
+    uint32_t c1 = nodes[node].offset;
+
+    double i0 = Importance(c0 , p);
+    double i1 = Importance(c1 , p);
+    double p0 = i0 / (i0 + i1);
+
+    if (u < p0) {
+      node = c0;
+      u = u / p0;
+      pmf *= p0;
+    } else {
+      node = c1;
+      u = std::min((u - p0) / (1.0 - p0) , 1.0);
+      pmf *= 1.0 - p0;
+    }
+  }
+
+  const LinearBvhNode& leaf = nodes[node];
+  double target = u * node_power[node];
+  uint32_t light = leaf.offset;
+  for (uint32_t i = leaf.offset; i < leaf.offset + leaf.prim_count; ++i) {
+    light = i;
+    if (target < lights[i].power) {
+      break;
+    }
+    target -= lights[i].power;
+  }
+
+  pmf *= lights[light].power / node_power[node];
+  return light;
+}
+
+double LightSampler::LightPmf(const Point3& p , uint32_t light) const {
+  switch (strategy) {
+    case LightSampling::UNIFORM:
+      return 1.0 / lights.size();
+
+    case LightSampling::POWER:
+      return lights[light].power / total_power;
+
+    case LightSampling::BVH:
+      break;
+  }
+
+  uint32_t node = light_leaf[light];
+  double pmf = lights[light].power / node_power[node];
+
+  while (node != 0) {
+    uint32_t parent = node_parent[node];
+    uint32_t sibling = (node == parent + 1) ?
+      nodes[parent].offset : parent + 1;
+
+    double importance = Importance(node , p);
+    pmf *= importance / (importance + Importance(sibling , p));
+    node = parent;
+  }
+
+  return pmf;
+}
+
+LightSampling LightSampler::Strategy() const {
+  return strategy;
+}
+
+void LightSampler::BuildAliasTable() {
+  const size_t num_lights = lights.size();
+
+  total_power = 0.0;
+  for (const auto& light : lights) {
+    total_power += light.power;
+  }
+
+  alias_prob.assign(num_lights , 1.0);
+  alias.resize(num_lights);
+
+  /// Vose's method , scaled probabilities below 1 are topped up by one above 1
+  std::vector<double> scaled(num_lights);
+  std::vector<uint32_t> small , large;
+  for (uint32_t i = 0; i < num_lights; ++i) {
+    alias[i] = i;
+    scaled[i] = lights[i].power * num_lights / total_power;
+    if (scaled[i] < 1.0) {
+      small.push_back(i);
+    } else {
+      large.push_back(i);
+    }
+  }
+
+  while (!small.empty() && !large.empty()) {
+    uint32_t s = small.back();
+    small.pop_back();
+    uint32_t l = large.back();
+
+    alias_prob[s] = scaled[s];
+    alias[s] = l;
+
+    scaled[l] -= 1.0 - scaled[s];
+    if (scaled[l] < 1.0) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+
+  /// whatever is left is 1 up to rounding
+  for (uint32_t i : small) {
+    alias_prob[i] = 1.0;
+  }
+  for (uint32_t i : large) {
+    alias_prob[i] = 1.0;
+  }
+}
+
+void LightSampler::BuildBvh() {
+  bbox = Aabb::empty;
+  if (lights.empty()) {
+    return;
+  }
+
+  std::vector<Aabb> light_bounds;
+  light_bounds.reserve(lights.size());
+  for (const auto& light : lights) {
+    light_bounds.push_back(light.bounds);
+    bbox = Aabb(bbox , light.bounds);
+  }
+
+  /// single light leaves keep the descent spatially aware all the way down
+  BvhBuildOptions options;
+  options.max_leaf_size = 1;
+
+  FlatBvh bvh = BvhBuilder(light_bounds , options).Build();
+  nodes = std::move(bvh.nodes);
+
+  std::vector<LightCollector::Entry> sorted;
+  sorted.reserve(lights.size());
+  for (uint32_t idx : bvh.prim_indices) {
+    sorted.push_back(lights[idx]);
+  }
+  lights = std::move(sorted);
+
+  /// children always come after their parent in the depth first layout
+  node_power.assign(nodes.size() , 0.0);
+  node_parent.assign(nodes.size() , 0);
+  light_leaf.assign(lights.size() , 0);
+  for (size_t n = nodes.size(); n-- > 0;) {
+    const LinearBvhNode& node = nodes[n];
+    if (node.IsLeaf()) {
+      for (uint32_t i = node.offset; i < node.offset + node.prim_count; ++i) {
+        node_power[n] += lights[i].power;
+        light_leaf[i] = uint32_t(n);
+      }
+    } else {
+      node_power[n] = node_power[n + 1] + node_power[node.offset];
+      node_parent[n + 1] = uint32_t(n);
+      node_parent[node.offset] = uint32_t(n);
+    }
+  }
+}
+
+double LightSampler::Importance(uint32_t node , const Point3& p) const {
+  const LinearBvhNode& n = nodes[node];
+
+  glm::dvec3 min(n.bounds[0][0] , n.bounds[0][1] , n.bounds[0][2]);
+  glm::dvec3 max(n.bounds[1][0] , n.bounds[1][1] , n.bounds[1][2]);
+  glm::dvec3 center = 0.5 * (min + max);
+
+  /// distance to the center , clamped to the box radius so points near or inside a node
+  ///   don't blow its weight up
+  glm::dvec3 d = glm::dvec3(p) - center;
+  double dist_sqrd = glm::dot(d , d);
+  double radius_sqrd = 0.25 * glm::dot(max - min , max - min);
+
+  return node_power[node] / std::max(dist_sqrd , radius_sqrd);
+}
+
+double LightSampler::LightPdfValue(uint32_t light , const Point3& origin , const glm::vec3& direction , double time) const {
+  const LightCollector::Entry& entry = lights[light];
+
+  if (entry.transform < 0) {
+    return entry.shape->PdfValue(origin , direction , time);
+  }
+
+  /// the density is of object space directions , it is moved over to the world directions
+  ///   Random hands out so lights under a non uniform scale are weighted right
+  const Transform& t = transforms[entry.transform];
+  double object_pdf = entry.shape->PdfValue(t.PointToObject(origin) , t.VectorToObject(direction) , time);
+  return (object_pdf > 0.0) ?
+    object_pdf * t.DensityToWorld(direction) : 0.0;
+}
@@ -0,0 +1,114 @@
+/**
+ * \file light_sampler.hpp
+ **/
+#ifndef LIGHT_SAMPLER_HPP
+#define LIGHT_SAMPLER_HPP
+
+#include <vector>
+
+#include "defines.hpp"
+#include "bvh_builder.hpp"
+#include "hittable.hpp"
+#include "transform.hpp"
+
+class Material;
+
+enum class LightSampling {
+  /// every light equally likely , the policy of HittableList::Random
+  UNIFORM ,
+  /// proportional to emitted power through an alias table , independent of the shading point
+  POWER ,
+  /// descends a bvh over the lights weighting each subtree by power over squared distance
+  BVH ,
+};
+
+/// gathers emitters while a Hittable graph walks itself through Hittable::CollectLights
+class LightCollector {
+  public:
+    /// explicit light lists use dummy materials , with this off every shape is taken as a
+    ///   light of unit radiance
+    bool require_emission = true;
+
+    /// area of the shape in its own space , skipped when it doesn't emit
+    void AddLight(const Hittable& shape , const Material* mat , double area);
+
+    /// instances wrap their children in a transform
+    void PushTransform(const Transform& transform);
+    void PopTransform();
+
+  private:
+    friend class LightSampler;
+
+    struct Entry {
+      const Hittable* shape;
+      /// index into transforms , -1 for shapes placed directly in the world
+      int32_t transform;
+      double power;
+      Aabb bounds;
+    };
+
+    std::vector<Entry> lights{};
+    std::vector<Transform> transforms{};
+    std::vector<int32_t> transform_stack{};
+};
+
+/// the set of lights of a scene , picks one per light sample. behaves as a Hittable over
+///   the lights so it plugs into HittablePdf , PdfValue only visits the lights whose bounds
+///   the direction passes through so both directions of the pdf are sublinear in the
+///   number of lights
+class LightSampler : public Hittable {
+  public:
+    LightSampler() {}
+
+    /// collects emissive surfaces from scene , or every surface when require_emission is off
+    LightSampler(const Hittable& scene , LightSampling strategy = LightSampling::BVH , bool require_emission = true);
+
+    virtual bool Hit(const Ray& r , Interval rayt , HitRecord& rec) const override;
+
+    virtual Aabb BoundingBox() const override;
+
+    virtual double PdfValue(const Point3& origin , const glm::vec3& direction , double time) const override;
+
+    virtual glm::vec3 Random(const Point3& origin , double time) const override;
+
+    bool Empty() const;
+
+    size_t NumLights() const;
+
+    /// picks a light for shading point p from the uniform number u , pmf is the
+    ///   probability it had of being picked
+    uint32_t SampleLight(const Point3& p , double u , double& pmf) const;
+
+    /// probability SampleLight picks light at p
+    double LightPmf(const Point3& p , uint32_t light) const;
+
+    LightSampling Strategy() const;
+
+  private:
+    LightSampling strategy = LightSampling::BVH;
+
+    /// leaf order of the light bvh
+    std::vector<LightCollector::Entry> lights{};
+    std::vector<Transform> transforms{};
+    double total_power = 0.0;
+
+    Aabb bbox = Aabb::empty;
+
+    /// alias table , light i keeps itself with probability alias_prob[i]
+    std::vector<double> alias_prob{};
+    std::vector<uint32_t> alias{};
+
+    std::vector<LinearBvhNode> nodes{};
+    std::vector<double> node_power{};
+    std::vector<uint32_t> node_parent{};
+    std::vector<uint32_t> light_leaf{};
+
+    void BuildAliasTable();
+    void BuildBvh();
+
+    double Importance(uint32_t node , const Point3& p) const;
+
+    double LightPdfValue(uint32_t light , const Point3& origin , const glm::vec3& direction , double time) const;
+};
+
+#endif // !LIGHT_SAMPLER_HPP
@@ -0,0 +1,92 @@
+/**
+ * \file linear_bvh.cpp
+ **/
+#include "linear_bvh.hpp"
+
+#include "compiled_scene.hpp"
+#include "light_sampler.hpp"
+
+BvhRay::BvhRay(const Ray& r) {
+  const Point3& o = r.Origin();
+  const glm::vec3& inv = r.InvDirection();
+  const glm::uvec3& neg = r.DirIsNeg();
+
+  for (uint32_t a = 0; a < 3; ++a) {
+    origin[a] = o[a];
+    inv_dir[a] = float(inv[a]);
+    dir_is_neg[a] = neg[a];
+  }
+}
+
+LinearBvh::LinearBvh(const std::vector<Ref<Hittable>>& objects , const BvhBuildOptions& options) {
+  std::vector<Aabb> prim_bounds;
+  prim_bounds.reserve(objects.size());
+
+  bbox = Aabb::empty;
+  for (const auto& obj : objects) {
+    prim_bounds.push_back(obj->BoundingBox());
+    bbox = Aabb(bbox , prim_bounds.back());
+  }
+
+  FlatBvh bvh = BvhBuilder(prim_bounds , options).Build();
+  nodes = std::move(bvh.nodes);
+  stats = std::move(bvh.stats);
+
+  primitives.reserve(objects.size());
+  for (uint32_t idx : bvh.prim_indices) {
+    primitives.push_back(objects[idx]);
+  }
+}
+
+bool LinearBvh::Hit(const Ray& r , Interval rayt , HitRecord& rec) const {
+  return TraverseLinearBvh(nodes , r , rayt , [this , &r , &rec](uint32_t first , uint32_t count , Interval& ray_t) {
+    bool hit = false;
+    for (uint32_t i = first; i < first + count; ++i) {
+      if (primitives[i]->Hit(r , ray_t , rec)) {
+        hit = true;
+        ray_t.max = rec.t;
+      }
+    }
+    return hit;
+  });
+}
+
+Aabb LinearBvh::BoundingBox() const {
+  return bbox;
+}
+
+double LinearBvh::PdfValue(const Point3& origin , const glm::vec3& direction , double time) const {
+  auto weight = 1.0 / primitives.size();
+  auto sum = 0.0;
+
+  for (const auto& prim : primitives) {
+    sum += weight * prim->PdfValue(origin , direction , time);
+  }
+
+  return sum;
+}
+
+glm::vec3 LinearBvh::Random(const Point3& origin , double time) const {
+  auto int_size = int32_t(primitives.size());
+  return primitives[RandomInt(0 , int_size - 1)]->Random(origin , time);
+}
+
+void LinearBvh::Compile(SceneCompiler& compiler) const {
+  for (const auto& obj : primitives) {
+    obj->Compile(compiler);
+  }
+}
+
+void LinearBvh::CollectLights(LightCollector& collector) const {
+  for (const auto& obj : primitives) {
+    obj->CollectLights(collector);
+  }
+}
+
+size_t LinearBvh::NumNodes() const {
+  return nodes.size();
+}
+
+const BvhBuildStats& LinearBvh::BuildStats() const {
+  return stats;
+}
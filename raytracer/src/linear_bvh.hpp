@@ -0,0 +1,126 @@
+/**
+ * \file linear_bvh.hpp
+ **/
+#ifndef LINEAR_BVH_HPP
+#define LINEAR_BVH_HPP
+
+#include <vector>
+
+#include "defines.hpp"
+#include "bvh_builder.hpp"
+#include "hittable.hpp"
+#include "hittable_list.hpp"
+#include "render_stats.hpp"
+
+/// per-ray constants for the float slab tests of a flattened bvh
+class BvhRay {
+  public:
+    float origin[3];
+    float inv_dir[3];
+    uint32_t dir_is_neg[3];
+
+    BvhRay(const Ray& r);
+};
+
+/// tests a node box against the ray and checks the overlap with [t_min , t_max].
+///   NaNs produced by 0 * inf (ray on a slab plane) fail the comparisons and leave the
+///   interval untouched , the far bound is padded to absorb float rounding
+inline bool IntersectNode(const LinearBvhNode& node , const BvhRay& ray , float t_min , float t_max) {
+  for (uint32_t a = 0; a < 3; ++a) {
+    float t_near = (node.bounds[ray.dir_is_neg[a]][a] - ray.origin[a]) * ray.inv_dir[a];
+    float t_far = (node.bounds[1 - ray.dir_is_neg[a]][a] - ray.origin[a]) * ray.inv_dir[a];
+    t_far *= 1.0f + 2.0f * 3.0f * std::numeric_limits<float>::epsilon();
+
+    if (t_near > t_min) t_min = t_near;
+    if (t_far < t_max) t_max = t_far;
+  }
+
+  return t_min <= t_max;
+}
+
+/// iterative front-to-back traversal with an explicit stack. leaf(first , count , rayt)
+///   tests a primitive range , returns true on a hit and shrinks rayt.max to the hit
+template <typename LeafFunc>
+inline bool TraverseLinearBvh(const std::vector<LinearBvhNode>& nodes , const Ray& r , Interval& rayt , LeafFunc&& leaf) {
+  if (nodes.empty()) {
+    return false;
+  }
+
+  BvhRay ray(r);
+
+  /// one entry per level at most , BvhBuilder bounds the depth
+  uint32_t stack[BvhBuilder::max_depth];
+  uint32_t stack_size = 0;
+  uint32_t current = 0;
+  bool hit_anything = false;
+  RT_STATS(uint64_t nodes_visited = 0;)
+
+  while (true) {
+    const LinearBvhNode& node = nodes[current];
+    RT_STATS(++nodes_visited;)
+
+    if (IntersectNode(node , ray , float(rayt.min) , float(rayt.max))) {
+      if (node.IsLeaf()) {
+        if (leaf(node.offset , uint32_t(node.prim_count) , rayt)) {
+          hit_anything = true;
+        }
+      } else {
+        /// visit the child on the near side of the split plane first
+        if (ray.dir_is_neg[node.axis]) {
+          stack[stack_size++] = current + 1;
+          current = node.offset;
+        } else {
+          stack[stack_size++] = node.offset;
+          current = current + 1;
+        }
+        continue;
+      }
+    }
+
+    if (stack_size == 0) {
+      break;
+    }
+    current = stack[--stack_size];
+  }
+
+  RT_STATS(ThreadStats().bvh_nodes_visited += nodes_visited;)
+
+  return hit_anything;
+}
+
+/// Hittable over a pointer-free , depth-first array of compact bvh nodes
+class LinearBvh : public Hittable {
+  public:
+    LinearBvh(HittableList list , const BvhBuildOptions& options = BvhBuildOptions())
+      : LinearBvh(list.objects , options) {}
+
+    LinearBvh(const std::vector<Ref<Hittable>>& objects , const BvhBuildOptions& options = BvhBuildOptions());
+
+    virtual bool Hit(const Ray& r , Interval rayt , HitRecord& rec) const override;
+
+    virtual Aabb BoundingBox() const override;
+    
+    virtual double PdfValue(const Point3& origin , const glm::vec3& direction , double time) const override;
+
+    virtual glm::vec3 Random(const Point3& origin , double time) const override;
+
+    virtual void Compile(SceneCompiler& compiler) const override;
+
+    virtual void CollectLights(LightCollector& collector) const override;
+
+    size_t NumNodes() const;
+
+    const BvhBuildStats& BuildStats() const;
+
+  private:
+    std::vector<LinearBvhNode> nodes{};
+
+    /// primitives in leaf order
+    std::vector<Ref<Hittable>> primitives{};
+
+    Aabb bbox;
+
+    BvhBuildStats stats;
+};
+
+#endif // !LINEAR_BVH_HPP
@@ -0,0 +1,269 @@
+/**
+ * \file mapped_file.cpp
+ **/
+#include "mapped_file.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+  #define WIN32_LEAN_AND_MEAN
+  #define NOMINMAX
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& file_name) {
+  Open(file_name);
+}
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& file_name) {
+  Close();
+
+  HANDLE file = CreateFileA(file_name.c_str() , GENERIC_READ , FILE_SHARE_READ , nullptr , OPEN_EXISTING ,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN , nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file , &file_size) || file_size.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file , nullptr , PAGE_READONLY , 0 , 0 , nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return false;
+  }
+
+  void* view = MapViewOfFile(mapping , FILE_MAP_READ , 0 , 0 , 0);
+  if (view == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  file_handle = file;
+  mapping_handle = mapping;
+  data = static_cast<uint8_t*>(view);
+  size = size_t(file_size.QuadPart);
+  return true;
+}
+
+bool MappedFile::Create(const std::string& file_name , size_t file_size) {
+  Close();
+
+  if (file_size == 0) {
+    return false;
+  }
+
+  HANDLE file = CreateFileA(file_name.c_str() , GENERIC_READ | GENERIC_WRITE , FILE_SHARE_READ , nullptr , CREATE_ALWAYS ,
+                            FILE_ATTRIBUTE_NORMAL , nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  /// mapping past the end grows the file to the mapping size
+  uint64_t size64 = uint64_t(file_size);
+  HANDLE mapping = CreateFileMappingA(file , nullptr , PAGE_READWRITE , DWORD(size64 >> 32) , DWORD(size64 & 0xffffffff) , nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return false;
+  }
+
+  void* view = MapViewOfFile(mapping , FILE_MAP_WRITE , 0 , 0 , 0);
+  if (view == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  file_handle = file;
+  mapping_handle = mapping;
+  data = static_cast<uint8_t*>(view);
+  size = file_size;
+  writable = true;
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data != nullptr) {
+    UnmapViewOfFile(data);
+  }
+  if (mapping_handle != nullptr) {
+    CloseHandle(mapping_handle);
+  }
+  if (file_handle != nullptr) {
+    CloseHandle(file_handle);
+  }
+
+  data = nullptr;
+  size = 0;
+  writable = false;
+  file_handle = nullptr;
+  mapping_handle = nullptr;
+}
+
+bool MappedFile::Flush() {
+  if (!writable) {
+    return false;
+  }
+
+  return FlushViewOfFile(data , 0) && FlushFileBuffers(file_handle);
+}
+
+#else
+
+bool MappedFile::Open(const std::string& file_name) {
+  Close();
+
+  int32_t file = open(file_name.c_str() , O_RDONLY);
+  if (file < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(file , &st) != 0 || st.st_size == 0) {
+    close(file);
+    return false;
+  }
+
+  void* view = mmap(nullptr , size_t(st.st_size) , PROT_READ , MAP_PRIVATE , file , 0);
+  if (view == MAP_FAILED) {
+    close(file);
+    return false;
+  }
+
+  /// loaders walk the file front to back once
+  madvise(view , size_t(st.st_size) , MADV_SEQUENTIAL);
+
+  fd = file;
+  data = static_cast<uint8_t*>(view);
+  size = size_t(st.st_size);
+  return true;
+}
+
+bool MappedFile::Create(const std::string& file_name , size_t file_size) {
+  Close();
+
+  if (file_size == 0) {
+    return false;
+  }
+
+  int32_t file = open(file_name.c_str() , O_RDWR | O_CREAT | O_TRUNC , 0644);
+  if (file < 0) {
+    return false;
+  }
+
+  if (ftruncate(file , off_t(file_size)) != 0) {
+    close(file);
+    return false;
+  }
+
+  void* view = mmap(nullptr , file_size , PROT_READ | PROT_WRITE , MAP_SHARED , file , 0);
+  if (view == MAP_FAILED) {
+    close(file);
+    return false;
+  }
+
+  fd = file;
+  data = static_cast<uint8_t*>(view);
+  size = file_size;
+  writable = true;
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data != nullptr) {
+    munmap(data , size);
+  }
+  if (fd >= 0) {
+    close(fd);
+  }
+
+  data = nullptr;
+  size = 0;
+  writable = false;
+  fd = -1;
+}
+
+bool MappedFile::Flush() {
+  if (!writable) {
+    return false;
+  }
+
+  return msync(data , size , MS_SYNC) == 0;
+}
+
+#endif // _WIN32
+
+bool MappedFile::IsOpen() const {
+  return data != nullptr;
+}
+
+bool MappedFile::IsWritable() const {
+  return writable;
+}
+
+const uint8_t* MappedFile::Data() const {
+  return data;
+}
+
+uint8_t* MappedFile::MutableData() {
+  return writable ?
+    data : nullptr;
+}
+
+size_t MappedFile::Size() const {
+  return size;
+}
+
+bool WriteFileAtomic(const std::string& file_name , std::initializer_list<FileChunk> chunks , const std::string& what) {
+  std::string tmp_name = file_name + ".tmp";
+
+  /// a half written temporary is never renamed over the target , nor left behind
+  auto fail = [&tmp_name](const std::string& message) {
+    std::error_code ignored;
+    std::filesystem::remove(tmp_name , ignored);
+    std::cerr << message << "\n";
+    return false;
+  };
+
+  std::ofstream file(tmp_name , std::ios::binary);
+  if (!file.is_open()) {
+    return fail("ERROR : Failed to open " + what + " : " + tmp_name);
+  }
+
+  for (const FileChunk& chunk : chunks) {
+    if (chunk.size > 0) {
+      file.write(static_cast<const char*>(chunk.data) , std::streamsize(chunk.size));
+    }
+  }
+
+  /// buffered data only reaches the disk on close , a full disk shows up there
+  file.close();
+  if (!file) {
+    return fail("ERROR : Failed to write " + what + " : " + tmp_name);
+  }
+
+  std::error_code err;
+  std::filesystem::rename(tmp_name , file_name , err);
+  if (err) {
+    return fail("ERROR : Failed to replace " + what + " : " + file_name + " : " + err.message());
+  }
+
+  return true;
+}
@@ -0,0 +1,73 @@
+/**
+ * \file mapped_file.hpp
+ **/
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+/// view of a whole file mapped into memory. the mapping lives as long as the object ,
+///   loaders parse straight out of Data() instead of reading into a buffer first. files made
+///   with Create are mapped shared and writable , stores land in the page cache and are
+///   visible to readers of the file before Flush
+class MappedFile {
+  public:
+    MappedFile() {}
+
+    MappedFile(const std::string& file_name);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// read only
+    bool Open(const std::string& file_name);
+
+    /// creates or truncates file_name to size zeroed bytes and maps it writable
+    bool Create(const std::string& file_name , size_t size);
+
+    void Close();
+
+    /// blocks until every written page reached the file
+    bool Flush();
+
+    bool IsOpen() const;
+
+    bool IsWritable() const;
+
+    const uint8_t* Data() const;
+
+    /// nullptr unless the file was made with Create
+    uint8_t* MutableData();
+
+    size_t Size() const;
+
+  private:
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    bool writable = false;
+
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#else
+    int32_t fd = -1;
+#endif
+};
+
+/// bytes WriteFileAtomic writes , empty chunks are skipped
+struct FileChunk {
+  const void* data;
+  size_t size;
+};
+
+/// writes chunks one after the other to a file next to file_name and renames it over
+///   file_name , so an interrupted write never leaves a torn file and readers see either
+///   the old or the new one. what names the file in error messages
+bool WriteFileAtomic(const std::string& file_name , std::initializer_list<FileChunk> chunks , const std::string& what);
+
+#endif // !MAPPED_FILE_HPP
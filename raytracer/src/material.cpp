@@ -6,6 +6,27 @@
 #include "defines.hpp"
 #include "hittable.hpp"
     
+void ScatterRecord::ClearPdf() {
+  builtin_pdf.emplace<std::monostate>();
+  custom_pdf = nullptr;
+}
+
+const Pdf* ScatterRecord::GetPdf() const {
+  if (custom_pdf != nullptr) {
+    return custom_pdf;
+  }
+
+  if (const CosinePdf* pdf = std::get_if<CosinePdf>(&builtin_pdf)) {
+    return pdf;
+  }
+
+  if (const SpherePdf* pdf = std::get_if<SpherePdf>(&builtin_pdf)) {
+    return pdf;
+  }
+
+  return nullptr;
+}
+
 bool Material::Scatter(const Ray& r_in , const HitRecord& rec , ScatterRecord& srec) const {
   return false;
 }
@@ -18,9 +39,17 @@ Color Material::Emitted(const Ray& r_in , const HitRecord& rec , double u , doub
   return Color(0 , 0 , 0);
 }
 
+Color Material::AverageEmission() const {
+  return Color(0 , 0 , 0);
+}
+
+StatMaterial Material::StatsCategory() const {
+  return StatMaterial::OTHER;
+}
+
 bool Lambertian::Scatter(const Ray& r_in , const HitRecord& rec , ScatterRecord& srec) const {
   srec.attenuation = texture->Value(rec.u , rec.v , rec.point);
-  srec.pdf = NewRef<CosinePdf>(rec.normal);
+  srec.SetPdf<CosinePdf>(rec.normal);
   srec.skip_pdf = false;
   return true;
 }
@@ -31,21 +60,29 @@ double Lambertian::ScatteringPdf(const Ray& r_in , const HitRecord& rec , const
     0 : cos_theta / pi;
 }
 
+StatMaterial Lambertian::StatsCategory() const {
+  return StatMaterial::LAMBERTIAN;
+}
+
 bool Metal::Scatter(const Ray& r_in , const HitRecord& rec , ScatterRecord& srec) const {
   glm::vec3 reflected = glm::reflect(r_in.Direction() , rec.normal);
   reflected = UnitVector(reflected) + (fuzz * RandomUnitVector());
 
   srec.attenuation = albedo;
-  srec.pdf = nullptr;
+  srec.ClearPdf();
   srec.skip_pdf = true;
   srec.skip_pdf_ray = Ray(rec.point , reflected , r_in.Time());
 
   return true;
 }
 
+StatMaterial Metal::StatsCategory() const {
+  return StatMaterial::METAL;
+}
+
 bool Dielectric::Scatter(const Ray& r_in , const HitRecord& rec , ScatterRecord& srec) const {
   srec.attenuation = Color(1.0 , 1.0 , 1.0);
-  srec.pdf = nullptr;
+  srec.ClearPdf();
   srec.skip_pdf = true;
 
   double ri = rec.front_face ? 
@@ -74,6 +111,10 @@ double Dielectric::Reflectance(double cos , double refraction_idx) {
   return r0 + (1 - r0) * glm::pow((1 - cos) , 5);
 }
 
+StatMaterial Dielectric::StatsCategory() const {
+  return StatMaterial::DIELECTRIC;
+}
+
 Color DiffuseLight::Emitted(const Ray& r_in , const HitRecord& rec , double u , double v , const Point3& p) const {
   // if (!rec.front_face) {
   //   return Color(0 , 0 , 0);
@@ -81,9 +122,18 @@ Color DiffuseLight::Emitted(const Ray& r_in , const HitRecord& rec , double u ,
   return texture->Value(u , v , p);
 }
 
+Color DiffuseLight::AverageEmission() const {
+  /// textures are sampled once at their center , exact for solid colors
+  return texture->Value(0.5 , 0.5 , Point3(0 , 0 , 0));
+}
+
+StatMaterial DiffuseLight::StatsCategory() const {
+  return StatMaterial::DIFFUSE_LIGHT;
+}
+
 bool Isotropic::Scatter(const Ray& r_in , const HitRecord& rec , ScatterRecord& srec) const {
   srec.attenuation = texture->Value(rec.u , rec.v , rec.point);
-  srec.pdf = NewRef<SpherePdf>();
+  srec.SetPdf<SpherePdf>();
   srec.skip_pdf = false;
   return true;
 }
@@ -91,3 +141,7 @@ bool Isotropic::Scatter(const Ray& r_in , const HitRecord& rec , ScatterRecord&
 double Isotropic::ScatteringPdf(const Ray& r_in , const HitRecord& rec , const Ray& scattered) const {
   return 1.0 / (4 * pi);
 }
+
+StatMaterial Isotropic::StatsCategory() const {
+  return StatMaterial::ISOTROPIC;
+}
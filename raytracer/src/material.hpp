@@ -4,19 +4,47 @@
 #ifndef MATERIAL_HPP
 #define MATERIAL_HPP
 
+#include <type_traits>
+#include <variant>
+
 #include "defines.hpp"
+#include "arena.hpp"
 #include "ray.hpp"
 #include "texture.hpp"
 #include "pdf.hpp"
+#include "render_stats.hpp"
 
 class HitRecord;
 
 class ScatterRecord {
   public:
     Color attenuation;
-    Ref<Pdf> pdf;
     bool skip_pdf;
     Ray skip_pdf_ray;
+
+    /// the built in pdfs are stored inline , anything else goes to the thread arena and
+    ///   lives until the camera starts the next sample
+    template <typename T , typename... Args>
+    const T& SetPdf(Args&&... args) {
+      if constexpr (std::is_same_v<T , CosinePdf> || std::is_same_v<T , SpherePdf>) {
+        custom_pdf = nullptr;
+        return builtin_pdf.emplace<T>(std::forward<Args>(args)...);
+      } else {
+        builtin_pdf.emplace<std::monostate>();
+        T* pdf = ThreadArena().New<T>(std::forward<Args>(args)...);
+        custom_pdf = pdf;
+        return *pdf;
+      }
+    }
+
+    void ClearPdf();
+
+    /// nullptr when the material didn't set one
+    const Pdf* GetPdf() const;
+
+  private:
+    std::variant<std::monostate , CosinePdf , SpherePdf> builtin_pdf;
+    const Pdf* custom_pdf = nullptr;
 };
 
 class Material {
@@ -26,6 +54,12 @@ class Material {
     virtual bool Scatter(const Ray& r_in , const HitRecord& rec , ScatterRecord& srec) const;
     virtual double ScatteringPdf(const Ray& r_in , const HitRecord& rec , const Ray& scattered) const;
     virtual Color Emitted(const Ray& r_in , const HitRecord& rec , double u , double v , const Point3& p) const;
+
+    /// rough radiance used to weight lights by power , black for materials that don't emit
+    virtual Color AverageEmission() const;
+
+    /// what the render statistics count hits of this material as
+    virtual StatMaterial StatsCategory() const;
 };
 
 class Lambertian : public Material {
@@ -38,6 +72,8 @@ class Lambertian : public Material {
     virtual bool Scatter(const Ray& r_in , const HitRecord& rec , ScatterRecord& srec) const override;
     virtual double ScatteringPdf(const Ray& r_in , const HitRecord& rec , const Ray& scattered) const override;
 
+    virtual StatMaterial StatsCategory() const override;
+
   private:
     Ref<Texture> texture;
 };
@@ -49,6 +85,8 @@ class Metal : public Material {
 
     virtual bool Scatter(const Ray& r_in , const HitRecord& rec , ScatterRecord& srec) const override;
 
+    virtual StatMaterial StatsCategory() const override;
+
   private:
     Color albedo;
     double fuzz;
@@ -61,6 +99,8 @@ class Dielectric : public Material {
 
     virtual bool Scatter(const Ray& r_in , const HitRecord& rec , ScatterRecord& srec) const override;
 
+    virtual StatMaterial StatsCategory() const override;
+
   private:
     double refraction_idx;
 
@@ -76,6 +116,10 @@ class DiffuseLight : public Material {
 
     virtual Color Emitted(const Ray& r_in , const HitRecord& rec , double u , double v , const Point3& p) const override;
 
+    virtual Color AverageEmission() const override;
+
+    virtual StatMaterial StatsCategory() const override;
+
   private:
     Ref<Texture> texture;
 };
@@ -92,6 +136,8 @@ class Isotropic : public Material {
 
     virtual double ScatteringPdf(const Ray& r_in , const HitRecord& rec , const Ray& scattered) const override;
 
+    virtual StatMaterial StatsCategory() const override;
+
   private:
     Ref<Texture> texture;
 };
@@ -0,0 +1,601 @@
+/**
+ * \file mesh_loader.cpp
+ **/
+#include "mesh_loader.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <initializer_list>
+#include <string_view>
+#include <unordered_map>
+
+#include "mapped_file.hpp"
+
+static bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+/// cursor over one line of a mapped text file
+class LineReader {
+  public:
+    LineReader(const char* begin , const char* end)
+      : cur(begin) , end(end) {}
+
+    void SkipSpaces() {
+      while (cur < end && IsSpace(*cur)) {
+        ++cur;
+      }
+    }
+
+    bool AtEnd() {
+      SkipSpaces();
+      return cur >= end;
+    }
+
+    std::string_view Token() {
+      SkipSpaces();
+      const char* start = cur;
+      while (cur < end && !IsSpace(*cur)) {
+        ++cur;
+      }
+      return std::string_view(start , size_t(cur - start));
+    }
+
+    bool Float(float& value) {
+      SkipSpaces();
+      /// from_chars rejects a leading plus
+      if (cur < end && *cur == '+') {
+        ++cur;
+      }
+      auto [ptr , ec] = std::from_chars(cur , end , value);
+      if (ec != std::errc()) {
+        return false;
+      }
+      cur = ptr;
+      return true;
+    }
+
+  private:
+    const char* cur;
+    const char* end;
+};
+
+/// one face corner , 0 marks a missing attribute since obj indices start at 1
+struct ObjCorner {
+  int64_t p = 0;
+  int64_t t = 0;
+  int64_t n = 0;
+
+  bool operator==(const ObjCorner& other) const {
+    return p == other.p && t == other.t && n == other.n;
+  }
+};
+
+struct ObjCornerHash {
+  size_t operator()(const ObjCorner& c) const {
+    uint64_t h = uint64_t(c.p) * 0x9E3779B97F4A7C15ull;
+    h ^= uint64_t(c.t) + 0x7F4A7C159E3779B9ull + (h << 6) + (h >> 2);
+    h ^= uint64_t(c.n) + 0x94D049BB133111EBull + (h << 6) + (h >> 2);
+    return size_t(h);
+  }
+};
+
+/// resolves a 1 based or negative (relative to the end) obj index , 0 on failure
+static int64_t ResolveObjIndex(std::string_view token , size_t count) {
+  if (token.empty()) {
+    return 0;
+  }
+
+  int64_t idx = 0;
+  auto [ptr , ec] = std::from_chars(token.data() , token.data() + token.size() , idx);
+  if (ec != std::errc() || ptr != token.data() + token.size()) {
+    return 0;
+  }
+
+  if (idx < 0) {
+    idx += int64_t(count) + 1;
+  }
+
+  return (idx >= 1 && idx <= int64_t(count)) ?
+    idx : 0;
+}
+
+static bool ParseObjCorner(std::string_view token , size_t num_p , size_t num_t , size_t num_n , ObjCorner& corner) {
+  size_t slash0 = token.find('/');
+  corner.p = ResolveObjIndex(token.substr(0 , slash0) , num_p);
+  if (corner.p == 0) {
+    return false;
+  }
+
+  if (slash0 == std::string_view::npos) {
+    return true;
+  }
+
+  std::string_view rest = token.substr(slash0 + 1);
+  size_t slash1 = rest.find('/');
+
+  std::string_view t = rest.substr(0 , slash1);
+  if (!t.empty()) {
+    corner.t = ResolveObjIndex(t , num_t);
+    if (corner.t == 0) {
+      return false;
+    }
+  }
+
+  if (slash1 != std::string_view::npos) {
+    std::string_view n = rest.substr(slash1 + 1);
+    if (!n.empty()) {
+      corner.n = ResolveObjIndex(n , num_n);
+      if (corner.n == 0) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+enum class PlyType : uint8_t {
+  INT8 , UINT8 , INT16 , UINT16 , INT32 , UINT32 , FLOAT32 , FLOAT64 , INVALID ,
+};
+
+static PlyType ParsePlyType(std::string_view name) {
+  if (name == "char" || name == "int8") return PlyType::INT8;
+  if (name == "uchar" || name == "uint8") return PlyType::UINT8;
+  if (name == "short" || name == "int16") return PlyType::INT16;
+  if (name == "ushort" || name == "uint16") return PlyType::UINT16;
+  if (name == "int" || name == "int32") return PlyType::INT32;
+  if (name == "uint" || name == "uint32") return PlyType::UINT32;
+  if (name == "float" || name == "float32") return PlyType::FLOAT32;
+  if (name == "double" || name == "float64") return PlyType::FLOAT64;
+  return PlyType::INVALID;
+}
+
+static uint32_t PlyTypeSize(PlyType type) {
+  switch (type) {
+    case PlyType::INT8: case PlyType::UINT8: return 1;
+    case PlyType::INT16: case PlyType::UINT16: return 2;
+    case PlyType::INT32: case PlyType::UINT32: case PlyType::FLOAT32: return 4;
+    case PlyType::FLOAT64: return 8;
+    default: return 0;
+  }
+}
+
+/// reads one value of type at p , swapping bytes when the file endianness differs
+static double ReadPlyValue(const uint8_t* p , PlyType type , bool swap) {
+  uint8_t bytes[8];
+  uint32_t size = PlyTypeSize(type);
+  std::memcpy(bytes , p , size);
+  if (swap) {
+    std::reverse(bytes , bytes + size);
+  }
+
+  switch (type) {
+    case PlyType::INT8: { int8_t v; std::memcpy(&v , bytes , 1); return v; }
+    case PlyType::UINT8: { uint8_t v; std::memcpy(&v , bytes , 1); return v; }
+    case PlyType::INT16: { int16_t v; std::memcpy(&v , bytes , 2); return v; }
+    case PlyType::UINT16: { uint16_t v; std::memcpy(&v , bytes , 2); return v; }
+    case PlyType::INT32: { int32_t v; std::memcpy(&v , bytes , 4); return v; }
+    case PlyType::UINT32: { uint32_t v; std::memcpy(&v , bytes , 4); return v; }
+    case PlyType::FLOAT32: { float v; std::memcpy(&v , bytes , 4); return v; }
+    case PlyType::FLOAT64: { double v; std::memcpy(&v , bytes , 8); return v; }
+    default: return 0.0;
+  }
+}
+
+/// false unless the value is a vertex index below num_vertices , checked before the
+///   cast since a negative , nan or out of range float is undefined behaviour to convert.
+///   faces refer to the vertex element so it has to come first , as every exporter writes it
+static bool ReadPlyIndex(const uint8_t* p , PlyType type , bool swap , size_t num_vertices , uint32_t& index) {
+  double value = ReadPlyValue(p , type , swap);
+  if (!(value >= 0.0 && value < double(num_vertices))) {
+    return false;
+  }
+
+  index = uint32_t(value);
+  return true;
+}
+
+struct PlyProperty {
+  std::string name;
+  PlyType type = PlyType::INVALID;
+  /// list properties only
+  bool is_list = false;
+  PlyType count_type = PlyType::INVALID;
+};
+
+struct PlyElement {
+  std::string name;
+  size_t count = 0;
+  std::vector<PlyProperty> properties{};
+
+  /// 0 when the element holds a list and records have to be walked
+  uint32_t FixedStride() const {
+    uint32_t stride = 0;
+    for (const auto& prop : properties) {
+      if (prop.is_list) {
+        return 0;
+      }
+      stride += PlyTypeSize(prop.type);
+    }
+    return stride;
+  }
+
+  int32_t PropertyIndex(std::initializer_list<std::string_view> names) const {
+    for (size_t i = 0; i < properties.size(); ++i) {
+      for (std::string_view name : names) {
+        if (properties[i].name == name) {
+          return int32_t(i);
+        }
+      }
+    }
+    return -1;
+  }
+};
+
+
+bool LoadObj(const std::string& file_name , MeshData& mesh) {
+  MappedFile file(file_name);
+  if (!file.IsOpen()) {
+    return false;
+  }
+
+  const char* cur = reinterpret_cast<const char*>(file.Data());
+  const char* end = cur + file.Size();
+
+  std::vector<Point3> positions;
+  std::vector<glm::vec2> uvs;
+  std::vector<glm::vec3> normals;
+
+  std::vector<ObjCorner> corners;
+  std::vector<ObjCorner> face;
+
+  while (cur < end) {
+    const char* line_end = static_cast<const char*>(std::memchr(cur , '\n' , size_t(end - cur)));
+    if (line_end == nullptr) {
+      line_end = end;
+    }
+
+    LineReader line(cur , line_end);
+    cur = line_end + 1;
+
+    std::string_view keyword = line.Token();
+    if (keyword == "v") {
+      Point3 p;
+      if (!line.Float(p.x) || !line.Float(p.y) || !line.Float(p.z)) {
+        return false;
+      }
+      positions.push_back(p);
+    } else if (keyword == "vt") {
+      glm::vec2 uv;
+      if (!line.Float(uv.x)) {
+        return false;
+      }
+      /// 1d texture coordinates leave v out
+      if (!line.Float(uv.y)) {
+        uv.y = 0.0f;
+      }
+      uvs.push_back(uv);
+    } else if (keyword == "vn") {
+      glm::vec3 n;
+      if (!line.Float(n.x) || !line.Float(n.y) || !line.Float(n.z)) {
+        return false;
+      }
+      normals.push_back(n);
+    } else if (keyword == "f") {
+      face.clear();
+      while (!line.AtEnd()) {
+        ObjCorner corner;
+        if (!ParseObjCorner(line.Token() , positions.size() , uvs.size() , normals.size() , corner)) {
+          return false;
+        }
+        face.push_back(corner);
+      }
+
+      if (face.size() < 3) {
+        return false;
+      }
+
+      for (size_t i = 1; i + 1 < face.size(); ++i) {
+        corners.push_back(face[0]);
+        corners.push_back(face[i]);
+        corners.push_back(face[i + 1]);
+      }
+    }
+    /// groups , objects , materials and smoothing groups don't affect the geometry
+  }
+
+  /// obj indexes every attribute separately , each distinct corner becomes one vertex
+  MeshData out;
+  out.indices.reserve(corners.size());
+
+  /// shading normals are kept only when every corner has one , a corner without would
+  ///   interpolate a zero normal. they are dropped from the keys too so vertices that only
+  ///   differ by normal merge
+  bool has_uvs = false;
+  bool has_normals = !corners.empty();
+  for (const auto& corner : corners) {
+    has_uvs |= corner.t != 0;
+    has_normals &= corner.n != 0;
+  }
+  if (!has_normals) {
+    for (auto& corner : corners) {
+      corner.n = 0;
+    }
+  }
+
+  std::unordered_map<ObjCorner , uint32_t , ObjCornerHash> vertex_ids;
+  vertex_ids.reserve(positions.size());
+
+  for (const auto& corner : corners) {
+    auto [itr , inserted] = vertex_ids.try_emplace(corner , uint32_t(out.positions.size()));
+    if (inserted) {
+      out.positions.push_back(positions[corner.p - 1]);
+      if (has_uvs) {
+        out.uvs.push_back(corner.t != 0 ? uvs[corner.t - 1] : glm::vec2(0.0f));
+      }
+      if (has_normals) {
+        out.normals.push_back(normals[corner.n - 1]);
+      }
+    }
+    out.indices.push_back(itr->second);
+  }
+
+  mesh = std::move(out);
+  return true;
+}
+
+bool LoadPly(const std::string& file_name , MeshData& mesh) {
+  MappedFile file(file_name);
+  if (!file.IsOpen()) {
+    return false;
+  }
+
+  const uint8_t* data = file.Data();
+  const uint8_t* end = data + file.Size();
+
+  std::string_view text(reinterpret_cast<const char*>(data) , file.Size());
+  if (text.substr(0 , 4) != "ply\n" && text.substr(0 , 5) != "ply\r\n") {
+    return false;
+  }
+
+  constexpr std::string_view end_header = "end_header";
+  size_t header_end = text.find(end_header);
+  if (header_end == std::string_view::npos) {
+    return false;
+  }
+
+  size_t body_offset = text.find('\n' , header_end);
+  if (body_offset == std::string_view::npos) {
+    return false;
+  }
+
+  bool big_endian = false;
+  std::vector<PlyElement> elements;
+
+  const char* line_cur = text.data();
+  const char* header_stop = text.data() + header_end;
+  while (line_cur < header_stop) {
+    const char* line_end = static_cast<const char*>(std::memchr(line_cur , '\n' , size_t(header_stop - line_cur)));
+    if (line_end == nullptr) {
+      line_end = header_stop;
+    }
+
+    LineReader line(line_cur , line_end);
+    line_cur = line_end + 1;
+
+    std::string_view keyword = line.Token();
+    if (keyword == "format") {
+      std::string_view format = line.Token();
+      if (format == "binary_little_endian") {
+        big_endian = false;
+      } else if (format == "binary_big_endian") {
+        big_endian = true;
+      } else {
+        /// ascii ply is rare for large assets and not worth a second parser
+        return false;
+      }
+    } else if (keyword == "element") {
+      PlyElement element;
+      element.name = std::string(line.Token());
+
+      std::string_view count = line.Token();
+      auto [ptr , ec] = std::from_chars(count.data() , count.data() + count.size() , element.count);
+      if (ec != std::errc()) {
+        return false;
+      }
+
+      elements.push_back(std::move(element));
+    } else if (keyword == "property") {
+      if (elements.empty()) {
+        return false;
+      }
+
+      PlyProperty prop;
+      std::string_view type = line.Token();
+      if (type == "list") {
+        prop.is_list = true;
+        prop.count_type = ParsePlyType(line.Token());
+        prop.type = ParsePlyType(line.Token());
+        if (prop.count_type == PlyType::INVALID) {
+          return false;
+        }
+      } else {
+        prop.type = ParsePlyType(type);
+      }
+
+      if (prop.type == PlyType::INVALID) {
+        return false;
+      }
+
+      prop.name = std::string(line.Token());
+      elements.back().properties.push_back(std::move(prop));
+    }
+  }
+
+  const bool swap = big_endian != (std::endian::native == std::endian::big);
+
+  MeshData out;
+  const uint8_t* cur = data + body_offset + 1;
+
+  for (const auto& element : elements) {
+    const uint32_t stride = element.FixedStride();
+
+    if (element.name == "vertex") {
+      if (stride == 0) {
+        return false;
+      }
+      if (size_t(end - cur) / stride < element.count) {
+        return false;
+      }
+
+      std::vector<uint32_t> offsets(element.properties.size() , 0);
+      for (size_t i = 1; i < offsets.size(); ++i) {
+        offsets[i] = offsets[i - 1] + PlyTypeSize(element.properties[i - 1].type);
+      }
+
+      int32_t x = element.PropertyIndex({ "x" });
+      int32_t y = element.PropertyIndex({ "y" });
+      int32_t z = element.PropertyIndex({ "z" });
+      if (x < 0 || y < 0 || z < 0) {
+        return false;
+      }
+
+      int32_t nx = element.PropertyIndex({ "nx" });
+      int32_t ny = element.PropertyIndex({ "ny" });
+      int32_t nz = element.PropertyIndex({ "nz" });
+      int32_t u = element.PropertyIndex({ "u" , "s" , "texture_u" , "texture_s" });
+      int32_t v = element.PropertyIndex({ "v" , "t" , "texture_v" , "texture_t" });
+
+      const bool has_normals = nx >= 0 && ny >= 0 && nz >= 0;
+      const bool has_uvs = u >= 0 && v >= 0;
+
+      out.positions.resize(element.count);
+      if (has_normals) {
+        out.normals.resize(element.count);
+      }
+      if (has_uvs) {
+        out.uvs.resize(element.count);
+      }
+
+      auto read = [&element , &offsets , swap](const uint8_t* record , int32_t prop) {
+        return float(ReadPlyValue(record + offsets[prop] , element.properties[prop].type , swap));
+      };
+
+      for (size_t i = 0; i < element.count; ++i) {
+        const uint8_t* record = cur + i * stride;
+
+        out.positions[i] = Point3(read(record , x) , read(record , y) , read(record , z));
+        if (has_normals) {
+          out.normals[i] = glm::vec3(read(record , nx) , read(record , ny) , read(record , nz));
+        }
+        if (has_uvs) {
+          out.uvs[i] = glm::vec2(read(record , u) , read(record , v));
+        }
+      }
+
+      cur += element.count * stride;
+      continue;
+    }
+
+    if (stride != 0) {
+      if (size_t(end - cur) / stride < element.count) {
+        return false;
+      }
+
+      cur += element.count * stride;
+      continue;
+    }
+
+    /// elements with lists have variable length records
+    const bool is_face = element.name == "face";
+    const int32_t indices_prop = is_face ?
+      element.PropertyIndex({ "vertex_indices" , "vertex_index" }) : -1;
+    if (is_face && (indices_prop < 0 || !element.properties[indices_prop].is_list)) {
+      return false;
+    }
+
+    if (is_face) {
+      out.indices.reserve(out.indices.size() + 3 * element.count);
+    }
+
+    for (size_t i = 0; i < element.count; ++i) {
+      for (size_t p = 0; p < element.properties.size(); ++p) {
+        const PlyProperty& prop = element.properties[p];
+
+        if (!prop.is_list) {
+          if (size_t(end - cur) < PlyTypeSize(prop.type)) {
+            return false;
+          }
+          cur += PlyTypeSize(prop.type);
+          continue;
+        }
+
+        if (size_t(end - cur) < PlyTypeSize(prop.count_type)) {
+          return false;
+        }
+
+        double count_value = ReadPlyValue(cur , prop.count_type , swap);
+        cur += PlyTypeSize(prop.count_type);
+
+        /// compared as a double so a negative , nan or huge count never reaches the cast
+        uint32_t item_size = PlyTypeSize(prop.type);
+        if (!(count_value >= 0.0 && count_value <= double(size_t(end - cur) / item_size))) {
+          return false;
+        }
+        size_t count = size_t(count_value);
+
+        if (int32_t(p) == indices_prop) {
+          if (count < 3) {
+            return false;
+          }
+
+          uint32_t first , prev;
+          if (!ReadPlyIndex(cur , prop.type , swap , out.positions.size() , first) ||
+              !ReadPlyIndex(cur + item_size , prop.type , swap , out.positions.size() , prev)) {
+            return false;
+          }
+
+          for (size_t k = 2; k < count; ++k) {
+            uint32_t next;
+            if (!ReadPlyIndex(cur + k * item_size , prop.type , swap , out.positions.size() , next)) {
+              return false;
+            }
+
+            out.indices.push_back(first);
+            out.indices.push_back(prev);
+            out.indices.push_back(next);
+            prev = next;
+          }
+        }
+
+        cur += count * item_size;
+      }
+    }
+  }
+
+  mesh = std::move(out);
+  return true;
+}
+
+bool LoadMesh(const std::string& file_name , MeshData& mesh) {
+  size_t dot = file_name.find_last_of('.');
+  if (dot == std::string::npos) {
+    return false;
+  }
+
+  std::string ext = file_name.substr(dot + 1);
+  std::transform(ext.begin() , ext.end() , ext.begin() , [](unsigned char c) { return char(std::tolower(c)); });
+
+  if (ext == "obj") {
+    return LoadObj(file_name , mesh);
+  }
+  if (ext == "ply") {
+    return LoadPly(file_name , mesh);
+  }
+
+  return false;
+}
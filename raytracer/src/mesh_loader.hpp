@@ -0,0 +1,25 @@
+/**
+ * \file mesh_loader.hpp
+ **/
+#ifndef MESH_LOADER_HPP
+#define MESH_LOADER_HPP
+
+#include <string>
+
+#include "triangle_mesh.hpp"
+
+/// loaders parse straight out of a MappedFile into the flat MeshData buffers. polygons are
+///   fan triangulated , the output is left untouched and false returned on malformed input
+
+/// positions , texture coordinates and normals of v/vt/vn lines , faces in any of the
+///   v , v/vt , v//vn and v/vt/vn forms including negative indices
+bool LoadObj(const std::string& file_name , MeshData& mesh);
+
+/// binary little or big endian ply with a vertex element (x y z , optional nx ny nz and
+///   u v / s t) and a face element with a vertex_indices list , other elements are skipped
+bool LoadPly(const std::string& file_name , MeshData& mesh);
+
+/// picks the loader from the file extension
+bool LoadMesh(const std::string& file_name , MeshData& mesh);
+
+#endif // !MESH_LOADER_HPP
@@ -24,7 +24,7 @@ glm::vec3 Onb::K() const {
 }
 
 glm::vec3 Onb::Local(double a , double b , double c) const {
-  return a * I() + b * J() * c * K();
+  return a * I() + b * J() + c * K();
 }
     
 glm::vec3 Onb::Local(const glm::vec3& v) const {
@@ -26,18 +26,18 @@ glm::vec3 CosinePdf::Generate() const {
   return ijk.Local(RandomCosineDirection());
 }
 
-HittablePdf::HittablePdf(const Ref<Hittable>& objects , const Point3& origin)
-  : objects(objects) , origin(origin) {}
+HittablePdf::HittablePdf(const Hittable& objects , const Point3& origin , double time)
+  : objects(&objects) , origin(origin) , time(time) {}
 
 double HittablePdf::Value(const glm::vec3& direction) const {
-  return objects->PdfValue(origin , direction);
+  return objects->PdfValue(origin , direction , time);
 }
 
 glm::vec3 HittablePdf::Generate() const {
-  return objects->Random(origin);
+  return objects->Random(origin , time);
 }
 
-MixturePdf::MixturePdf(Ref<Pdf> p0 , Ref<Pdf> p1) {
+MixturePdf::MixturePdf(const Pdf* p0 , const Pdf* p1) {
   dists[0] = p0;
   dists[1] = p1;
 }
@@ -35,30 +35,33 @@ class CosinePdf : public Pdf {
     Onb ijk;
 };
 
+/// non owning , built on the stack per bounce. objects must outlive the pdf , time is the
+///   time of the ray being scattered so moving lights are sampled where they are
 class HittablePdf : public Pdf {
   public:
-    HittablePdf(const Ref<Hittable>& objects , const Point3& origin);
+    HittablePdf(const Hittable& objects , const Point3& origin , double time);
     virtual ~HittablePdf() override {}
 
-
     virtual double Value(const glm::vec3& direction) const override;
     virtual glm::vec3 Generate() const override;
 
   private:
-    Ref<Hittable> objects;
+    const Hittable* objects;
     Point3 origin;
+    double time;
 };
 
+/// non owning , both pdfs must outlive the mixture
 class MixturePdf : public Pdf {
   public:
-    MixturePdf(Ref<Pdf> p0 , Ref<Pdf> p1);
+    MixturePdf(const Pdf* p0 , const Pdf* p1);
     virtual ~MixturePdf() override {}
 
     virtual double Value(const glm::vec3& direction) const override;
     virtual glm::vec3 Generate() const override;
 
   private:
-    Ref<Pdf> dists[2];
+    const Pdf* dists[2];
 };
 
 #endif // !PDF_HPP
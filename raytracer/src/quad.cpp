@@ -4,6 +4,9 @@
 #include "quad.hpp"
 
 #include "defines.hpp"
+#include "compiled_scene.hpp"
+#include "light_sampler.hpp"
+#include "render_stats.hpp"
 
 Quad::Quad(const Point3& Q , const glm::vec3& u , const glm::vec3& v , Ref<Material> mat) 
     : Q(Q) , u(u) , v(v) , material(mat) {
@@ -12,12 +15,14 @@ Quad::Quad(const Point3& Q , const glm::vec3& u , const glm::vec3& v , Ref<Mater
   D = glm::dot(normal , Q);
   w = n / glm::dot(n , n);
 
-  area = n.length();
+  area = glm::length(n);
 
   SetBoundingBox();
 }
     
 bool Quad::Hit(const Ray& r , Interval rayt , HitRecord& rec) const {
+  RT_STATS(ThreadStats().AddPrimTests(StatPrim::QUAD , 1);)
+
   auto denom = glm::dot(normal , r.Direction());
     
   if (std::fabs(denom) < 1e-8) {
@@ -40,7 +45,7 @@ bool Quad::Hit(const Ray& r , Interval rayt , HitRecord& rec) const {
 
   rec.t = t;
   rec.point = intersection;
-  rec.mat = material;
+  rec.mat = material.get();
   rec.SetFaceNormal(r , normal);
 
   return true;
@@ -50,14 +55,14 @@ Aabb Quad::BoundingBox() const {
   return bbox;
 }
     
-double Quad::PdfValue(const Point3& origin , const glm::vec3& direction) const {
+double Quad::PdfValue(const Point3& origin , const glm::vec3& direction , double time) const {
   HitRecord rec;
-  if (!Hit(Ray(origin , direction) , Interval(0.001 , infinity) , rec)) {
+  if (!Hit(Ray(origin , direction , time) , Interval(0.001 , infinity) , rec)) {
     return 0.0;
   }
 
   double dist_sqrd = rec.t * rec.t * LengthSquared(direction);
-  double cosine = std::fabs(glm::dot(direction , rec.normal)) / direction.length();
+  double cosine = std::fabs(glm::dot(direction , rec.normal)) / glm::length(direction);
   if (cosine == 0) {
     return 0.0;
   }
@@ -65,11 +70,19 @@ double Quad::PdfValue(const Point3& origin , const glm::vec3& direction) const {
   return dist_sqrd / (cosine * area);
 }
 
-glm::vec3 Quad::Random(const Point3& origin) const {
+glm::vec3 Quad::Random(const Point3& origin , double) const {
   auto p = Q + (RandomDouble() * u) + (RandomDouble() * v);
   return p - origin;
 }
 
+void Quad::Compile(SceneCompiler& compiler) const {
+  compiler.AddQuad(Q , u , v , normal , w , D , material);
+}
+
+void Quad::CollectLights(LightCollector& collector) const {
+  collector.AddLight(*this , material.get() , area);
+}
+
 void Quad::SetBoundingBox() {
   auto bbox_diagonal1 = Aabb(Q , Q + u + v);
   auto bbox_diagonal2 = Aabb(Q + u , Q + v);
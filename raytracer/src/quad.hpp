@@ -17,9 +17,13 @@ class Quad : public Hittable {
 
     virtual Aabb BoundingBox() const override;
     
-    virtual double PdfValue(const Point3& origin , const glm::vec3& direction) const override;
+    virtual double PdfValue(const Point3& origin , const glm::vec3& direction , double time) const override;
 
-    virtual glm::vec3 Random(const Point3& origin) const override;
+    virtual glm::vec3 Random(const Point3& origin , double time) const override;
+
+    virtual void Compile(SceneCompiler& compiler) const override;
+
+    virtual void CollectLights(LightCollector& collector) const override;
 
   private:
     double D;
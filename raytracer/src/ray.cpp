@@ -3,18 +3,14 @@
  **/
 #include "ray.hpp"
 
-const Point3& Ray::Origin() const { 
-  return origin; 
-}
-
-const glm::vec3& Ray::Direction() const { 
-  return direction; 
+Ray::Ray(const Point3& origin , const glm::vec3& direction , double time)
+    : origin(origin) , direction(direction) , tm(time) {
+  /// the sign comes from the reciprocal so -0 directions count as negative , the same
+  ///   way they turn into -inf
+  inv_direction = 1.0f / direction;
+  dir_is_neg = glm::uvec3(glm::lessThan(inv_direction , glm::vec3(0.0f)));
 }
 
 Point3 Ray::At(double t) const {
   return origin + t * direction;
 }
-
-double Ray::Time() const {
-  return tm;
-}
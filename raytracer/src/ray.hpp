@@ -12,21 +12,30 @@ class Ray {
   public:
     Ray() {}
     Ray(const Point3& origin , const glm::vec3& direction)
-      : origin(origin) , direction(direction) , tm(0) {}
-    Ray(const Point3& origin , const glm::vec3& direction , double time)
-      : origin(origin) , direction(direction) , tm(time) {}
+      : Ray(origin , direction , 0) {}
+    Ray(const Point3& origin , const glm::vec3& direction , double time);
 
-    const Point3& Origin() const;
-    const glm::vec3& Direction() const;
+    /// accessors are defined inline , they sit inside every box and primitive test
+    const Point3& Origin() const { return origin; }
+    const glm::vec3& Direction() const { return direction; }
+
+    /// 1 / direction per component , +-inf for zero components
+    const glm::vec3& InvDirection() const { return inv_direction; }
+
+    /// 1 where the direction component is negative , indexes the near slab of a box
+    const glm::uvec3& DirIsNeg() const { return dir_is_neg; }
 
     Point3 At(double t) const;
 
-    double Time() const;
+    double Time() const { return tm; }
 
   private:
     Point3 origin;
     glm::vec3 direction;
     double tm;
+
+    glm::vec3 inv_direction;
+    glm::uvec3 dir_is_neg;
 };
 
 #endif // !RAY_HPP
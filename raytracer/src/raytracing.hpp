@@ -10,14 +10,18 @@
 #include "hittable_list.hpp"
 #include "sphere.hpp"
 #include "quad.hpp"
+#include "scene_loader.hpp"
+#include "triangle_mesh.hpp"
 #include "camera.hpp"
 #include "material.hpp"
 #include "bvh.hpp"
+#include "linear_bvh.hpp"
+#include "mesh_loader.hpp"
+#include "wide_bvh.hpp"
 #include "texture.hpp"
 
 static void BouncingSpheres(const std::string& file_name) {
   HittableList world;
-  Ref<Hittable> lights = NewRef<HittableList>();
 
   auto checker = NewRef<CheckerTexture>(0.32 , Color(0.2 , 0.3 , 0.1) , Color(0.9 , 0.9 , 0.9));
   auto ground_mat = NewRef<Lambertian>(checker);
@@ -62,7 +66,7 @@ static void BouncingSpheres(const std::string& file_name) {
   auto mat3 = NewRef<Metal>(Color(0.7 , 0.6 , 0.5) , 0.0);
   world.Add(NewRef<Sphere>(Point3(4 , 1 , 0) , 1.0 , mat3));
 
-  world = HittableList(NewRef<BvhNode>(world));
+  world = HittableList(NewRef<WideBvh>(world));
 
   Camera cam;
   cam.aspect_ratio = 16.0 / 9.0;
@@ -82,12 +86,11 @@ static void BouncingSpheres(const std::string& file_name) {
   cam.img_file = file_name;
 
   /// Rendering
-  cam.Render(world , lights);
+  cam.Render(world);
 }
 
 static void CheckeredSpheres(const std::string& file_name) {
   HittableList world;
-  Ref<Hittable> lights = NewRef<HittableList>();
   
   auto checker = NewRef<CheckerTexture>(0.32 , Color(0.2 , 0.3 , 0.1) , Color(0.9 , 0.9 , 0.9));
   auto checker_mat = NewRef<Lambertian>(checker);
@@ -112,7 +115,7 @@ static void CheckeredSpheres(const std::string& file_name) {
 
   cam.img_file = file_name;
 
-  cam.Render(world , lights);
+  cam.Render(world);
 }
 
 static void Earth(const std::string& file_name) {
@@ -137,13 +140,11 @@ static void Earth(const std::string& file_name) {
 
   cam.img_file = file_name;
 
-  Ref<Hittable> lights = NewRef<HittableList>();
-  cam.Render(HittableList(globe) , lights);
+  cam.Render(HittableList(globe));
 }
 
 static void PerlinSpheres(const std::string& file_name , double scale) {
   HittableList world;
-  Ref<Hittable> lights = NewRef<HittableList>();
 
   auto pertext = NewRef<NoiseTexture>(scale);
   world.Add(NewRef<Sphere>(Point3(0 , -1000 , 0) , 1000 , NewRef<Lambertian>(pertext)));
@@ -166,12 +167,11 @@ static void PerlinSpheres(const std::string& file_name , double scale) {
 
   cam.img_file = file_name;
 
-  cam.Render(world , lights);
+  cam.Render(world);
 }
 
 static void Quads(const std::string& file_name) {
   HittableList world;
-  Ref<Hittable> lights = NewRef<HittableList>();
 
   auto left_red = NewRef<Lambertian>(Color(1.0 , 0.2 , 0.2));
   auto back_green = NewRef<Lambertian>(Color(0.2 , 1.0 , 0.2));
@@ -202,20 +202,19 @@ static void Quads(const std::string& file_name) {
 
   cam.img_file = file_name;
 
-  cam.Render(world , lights);
+  cam.Render(world);
 }
 
 static void SimpleLight(const std::string& file_name , double scale) {
   HittableList world;
-  Ref<HittableList> lights = NewRef<HittableList>();
 
   auto pertext = NewRef<NoiseTexture>(scale);
   world.Add(NewRef<Sphere>(Point3(0 , -1000 , 0) , 1000 , NewRef<Lambertian>(pertext)));
   world.Add(NewRef<Sphere>(Point3(0 , 2 , 0) , 2 , NewRef<Lambertian>(pertext)));
 
-  auto difflight = NewRef<Material>();
-  lights->Add(NewRef<Sphere>(Point3(0 , 7 , 0) , 2 , difflight));
-  lights->Add(NewRef<Quad>(Point3(3 , 1 , -2) , glm::vec3(2 , 0 , 0) , glm::vec3(0 , 2 , 0) , difflight));
+  auto difflight = NewRef<DiffuseLight>(Color(4 , 4 , 4));
+  world.Add(NewRef<Sphere>(Point3(0 , 7 , 0) , 2 , difflight));
+  world.Add(NewRef<Quad>(Point3(3 , 1 , -2) , glm::vec3(2 , 0 , 0) , glm::vec3(0 , 2 , 0) , difflight));
 
   Camera cam;
 
@@ -234,11 +233,12 @@ static void SimpleLight(const std::string& file_name , double scale) {
 
   cam.img_file = file_name;
 
-  cam.Render(world , lights);
+  cam.Render(world);
 }
 
 static void CornellBox(const std::string& file_name) {
   HittableList world;
+  Ref<HittableList> lights = NewRef<HittableList>();
 
   auto red = NewRef<Lambertian>(Color(0.65 , 0.05 , 0.05));
   auto white = NewRef<Lambertian>(Color(0.73 , 0.73 , 0.73));
@@ -253,6 +253,9 @@ static void CornellBox(const std::string& file_name) {
   
   world.Add(NewRef<Quad>(Point3(343 , 554 , 332) , glm::vec3(-130 , 0 , 0) , glm::vec3(0 , 0 , -105) , light));
 
+  auto empty_material = NewRef<Material>();
+  lights->Add(NewRef<Quad>(Point3(343 , 554 , 332) , glm::vec3(-130 , 0 , 0) , glm::vec3(0 , 0 , -105) , empty_material));
+
   Ref<Material> aluminum = NewRef<Metal>(Color(0.8 , 0.85 , 0.88) , 0.0);
   Ref<Hittable> box1 = CreateBox(Point3(0 , 0 , 0) , Point3(165 , 330 , 165) , aluminum);
   box1 = NewRef<RotateY>(box1 , 15);
@@ -267,12 +270,10 @@ static void CornellBox(const std::string& file_name) {
 #else
   auto glass = NewRef<Dielectric>(1.5);
   world.Add(NewRef<Sphere>(Point3(190 , 90 , 190) , 90 , glass));
-#endif 
 
-  Ref<HittableList> lights = NewRef<HittableList>();
-  auto m = NewRef<Material>();
-  lights->Add(NewRef<Quad>(Point3(343 , 554 , 332) , glm::vec3(-130 , 0 , 0) , glm::vec3(0 , 0 , -105) , m));
-  // lights.Add(NewRef<Sphere>(Point3(190 , 90 , 190) , 90 , m));
+  /// the glass sphere is aimed at too so the caustic under it converges
+  lights->Add(NewRef<Sphere>(Point3(190 , 90 , 190) , 90 , empty_material));
+#endif 
 
   Camera cam;
 
@@ -289,6 +290,9 @@ static void CornellBox(const std::string& file_name) {
 
   cam.defocus_angle = 0;
 
+  /// the sphere doesn't emit , weighting it by area would starve the light
+  cam.light_sampling = LightSampling::UNIFORM;
+
   cam.img_file = file_name;
 
   cam.Render(world , lights);
@@ -296,7 +300,6 @@ static void CornellBox(const std::string& file_name) {
 
 static void CornellSmoke(const std::string& file_name) {
   HittableList world;
-  Ref<HittableList> lights = NewRef<HittableList>();
 
   auto red = NewRef<Lambertian>(Color(0.65 , 0.05 , 0.05));
   auto white = NewRef<Lambertian>(Color(0.73 , 0.73 , 0.73));
@@ -339,12 +342,11 @@ static void CornellSmoke(const std::string& file_name) {
 
   cam.img_file = file_name;
 
-  cam.Render(world , lights);
+  cam.Render(world);
 }
 
 static void FinalScene(const std::string& file_name , int img_width , int samples_per_pixel , int max_depth) {
   HittableList boxes1;
-  Ref<HittableList> lights = NewRef<HittableList>();
 
   auto ground = NewRef<Lambertian>(Color(0.48 , 0.83 , 0.53));
 
@@ -365,10 +367,10 @@ static void FinalScene(const std::string& file_name , int img_width , int sample
 
   HittableList world;
 
-  world.Add(NewRef<BvhNode>(boxes1));
+  world.Add(NewRef<WideBvh>(boxes1));
 
-  auto light = NewRef<Material>();
-  lights->Add(NewRef<Quad>(Point3(123 , 554 , 147) , glm::vec3(300 , 0 , 0) , glm::vec3(0 , 0 , 265) , light));
+  auto light = NewRef<DiffuseLight>(Color(7 , 7 , 7));
+  world.Add(NewRef<Quad>(Point3(123 , 554 , 147) , glm::vec3(300 , 0 , 0) , glm::vec3(0 , 0 , 265) , light));
 
   auto center1 = Point3(400, 400, 200);
   auto center2 = center1 + glm::vec3(30,0,0);
@@ -398,7 +400,7 @@ static void FinalScene(const std::string& file_name , int img_width , int sample
     boxes2.Add(NewRef<Sphere>(RandomVec3(0 , 165) , 10 , white));
   }
 
-  world.Add(NewRef<Translate>(NewRef<RotateY>(NewRef<BvhNode>(boxes2) , 15) , glm::vec3(-100 , 270 , 395)));
+  world.Add(NewRef<Translate>(NewRef<RotateY>(NewRef<WideBvh>(boxes2) , 15) , glm::vec3(-100 , 270 , 395)));
 
   Camera cam;
 
@@ -415,12 +417,13 @@ static void FinalScene(const std::string& file_name , int img_width , int sample
 
   cam.defocus_angle = 0;
 
-  cam.Render(world , lights);
+  cam.img_file = file_name;
+
+  cam.Render(world);
 }
 
 static void Stratification(const std::string& file) {
   HittableList world;
-  Ref<HittableList> lights = NewRef<HittableList>();
 
   auto red = NewRef<Lambertian>(Color(0.65 , 0.05 , 0.05));
   auto white = NewRef<Lambertian>(Color(0.73 , 0.73 , 0.73));
@@ -462,7 +465,7 @@ static void Stratification(const std::string& file) {
 
   cam.img_file = file;
 
-  cam.Render(world , lights);
+  cam.Render(world);
 }
 
 #endif // !RAYTRACING_HPP
@@ -0,0 +1,239 @@
+/**
+ * \file render_stats.cpp
+ **/
+#include "render_stats.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+static const char* ray_names[RenderStats::num_ray_types] = {
+  "camera" , "bounce" , "shadow"
+};
+
+static const char* prim_names[RenderStats::num_prim_types] = {
+  "sphere" , "moving_sphere" , "quad" , "triangle" , "medium" , "instance"
+};
+
+static const char* material_names[RenderStats::num_material_types] = {
+  "lambertian" , "metal" , "dielectric" , "diffuse_light" , "isotropic" , "other"
+};
+
+static const char* phase_names[RenderStats::num_phases] = {
+  "build" , "trace" , "write"
+};
+
+/// the counters of every live thread , threads fold theirs into retired when they exit
+class StatsRegistry {
+  public:
+    std::mutex mutex;
+    std::vector<RenderStats*> threads{};
+    RenderStats retired;
+};
+
+static StatsRegistry& Registry() {
+  static StatsRegistry registry;
+  return registry;
+}
+
+class ThreadStatsSlot {
+  public:
+    RenderStats stats;
+
+    ThreadStatsSlot() {
+      StatsRegistry& registry = Registry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      registry.threads.push_back(&stats);
+    }
+
+    ~ThreadStatsSlot() {
+      StatsRegistry& registry = Registry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      registry.retired.Merge(stats);
+      registry.threads.erase(std::find(registry.threads.begin() , registry.threads.end() , &stats));
+    }
+};
+
+RenderStats& ThreadStats() {
+  thread_local ThreadStatsSlot slot;
+  return slot.stats;
+}
+
+void ResetThreadStats() {
+  StatsRegistry& registry = Registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+
+  for (RenderStats* stats : registry.threads) {
+    *stats = RenderStats();
+  }
+  registry.retired = RenderStats();
+}
+
+RenderStats CollectThreadStats() {
+  StatsRegistry& registry = Registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+
+  RenderStats total = registry.retired;
+  for (const RenderStats* stats : registry.threads) {
+    total.Merge(*stats);
+  }
+  return total;
+}
+
+uint64_t RenderStats::NumRays(StatRay type) const {
+  uint64_t total = 0;
+  for (uint32_t d = 0; d <= max_depth; ++d) {
+    total += rays[uint32_t(type)][d];
+  }
+  return total;
+}
+
+uint64_t RenderStats::NumRays() const {
+  uint64_t total = 0;
+  for (uint32_t t = 0; t < num_ray_types; ++t) {
+    total += NumRays(StatRay(t));
+  }
+  return total;
+}
+
+uint64_t RenderStats::NumPrimTests() const {
+  uint64_t total = 0;
+  for (uint32_t p = 0; p < num_prim_types; ++p) {
+    total += prim_tests[p];
+  }
+  return total;
+}
+
+void RenderStats::Merge(const RenderStats& other) {
+  for (uint32_t t = 0; t < num_ray_types; ++t) {
+    for (uint32_t d = 0; d <= max_depth; ++d) {
+      rays[t][d] += other.rays[t][d];
+    }
+  }
+
+  bvh_nodes_visited += other.bvh_nodes_visited;
+
+  for (uint32_t p = 0; p < num_prim_types; ++p) {
+    prim_tests[p] += other.prim_tests[p];
+  }
+
+  for (uint32_t m = 0; m < num_material_types; ++m) {
+    material_hits[m] += other.material_hits[m];
+  }
+
+  rr_terminations += other.rr_terminations;
+
+  for (uint32_t p = 0; p < num_phases; ++p) {
+    phase_seconds[p] += other.phase_seconds[p];
+  }
+}
+
+void RenderStats::Print() const {
+  uint64_t num_rays = NumRays();
+  double per_ray = (num_rays > 0) ?
+    1.0 / double(num_rays) : 0.0;
+
+  spdlog::info("Render stats : {} rays , {} camera , {} bounce , {} shadow" , num_rays ,
+               NumRays(StatRay::CAMERA) , NumRays(StatRay::BOUNCE) , NumRays(StatRay::SHADOW));
+
+  for (uint32_t t = 0; t < num_ray_types; ++t) {
+    std::string depths;
+    for (uint32_t d = 0; d <= max_depth; ++d) {
+      if (rays[t][d] > 0) {
+        depths += fmt::format(" {}{}:{}" , d , d == max_depth ? "+" : "" , rays[t][d]);
+      }
+    }
+
+    if (!depths.empty()) {
+      spdlog::info("  {} rays by depth :{}" , ray_names[t] , depths);
+    }
+  }
+
+  spdlog::info("  bvh nodes visited : {} , {:.2f} per ray" , bvh_nodes_visited , double(bvh_nodes_visited) * per_ray);
+
+  std::string prims;
+  for (uint32_t p = 0; p < num_prim_types; ++p) {
+    if (prim_tests[p] > 0) {
+      prims += fmt::format(" , {} {}" , prim_tests[p] , prim_names[p]);
+    }
+  }
+  spdlog::info("  primitive tests : {} , {:.2f} per ray{}" , NumPrimTests() , double(NumPrimTests()) * per_ray , prims);
+
+  std::string materials;
+  for (uint32_t m = 0; m < num_material_types; ++m) {
+    if (material_hits[m] > 0) {
+      materials += fmt::format("{}{} {}" , materials.empty() ? " " : " , " , material_hits[m] , material_names[m]);
+    }
+  }
+  spdlog::info("  material hits :{}" , materials.empty() ? " none" : materials);
+
+  spdlog::info("  russian roulette terminations : {}" , rr_terminations);
+
+  spdlog::info("  phases : build {:.1f}ms , trace {:.1f}ms , write {:.1f}ms" , phase_seconds[0] * 1e3 ,
+               phase_seconds[1] * 1e3 , phase_seconds[2] * 1e3);
+}
+
+/// counters of an enum as an object keyed by its names
+template <uint32_t N>
+static void WriteJsonCounts(std::ostream& out , const char* key , const uint64_t (&counts)[N] , const char* const (&names)[N]) {
+  out << "  \"" << key << "\" : { ";
+  for (uint32_t i = 0; i < N; ++i) {
+    out << "\"" << names[i] << "\" : " << counts[i] << (i + 1 < N ? " , " : " ");
+  }
+  out << "}";
+}
+
+bool RenderStats::WriteJson(const std::string& file_name) const {
+  std::ofstream file(file_name);
+  if (!file.is_open()) {
+    std::cerr << "ERROR : Failed to open stats file : " << file_name << "\n";
+    return false;
+  }
+
+  file << "{\n";
+  file << "  \"version\" : 1 ,\n";
+  file << "  \"rays\" : " << NumRays() << " ,\n";
+
+  /// one array per ray type , index = depth and the last entry holds every deeper ray
+  file << "  \"rays_by_depth\" : {\n";
+  for (uint32_t t = 0; t < num_ray_types; ++t) {
+    file << "    \"" << ray_names[t] << "\" : [ ";
+    for (uint32_t d = 0; d <= max_depth; ++d) {
+      file << rays[t][d] << (d < max_depth ? " , " : " ");
+    }
+    file << "]" << (t + 1 < num_ray_types ? " ," : "") << "\n";
+  }
+  file << "  } ,\n";
+
+  file << "  \"bvh_nodes_visited\" : " << bvh_nodes_visited << " ,\n";
+
+  WriteJsonCounts(file , "prim_tests" , prim_tests , prim_names);
+  file << " ,\n";
+
+  WriteJsonCounts(file , "material_hits" , material_hits , material_names);
+  file << " ,\n";
+
+  file << "  \"rr_terminations\" : " << rr_terminations << " ,\n";
+
+  file << "  \"phase_seconds\" : { ";
+  for (uint32_t p = 0; p < num_phases; ++p) {
+    char seconds[64];
+    std::snprintf(seconds , sizeof(seconds) , "%.6f" , phase_seconds[p]);
+    file << "\"" << phase_names[p] << "\" : " << seconds << (p + 1 < num_phases ? " , " : " ");
+  }
+  file << "}\n";
+
+  file << "}\n";
+
+  if (!file) {
+    std::cerr << "ERROR : Failed to write stats file : " << file_name << "\n";
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,119 @@
+/**
+ * \file render_stats.hpp
+ **/
+#ifndef RENDER_STATS_HPP
+#define RENDER_STATS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/// counters are only compiled in with RT_ENABLE_STATS defined , every hook goes through
+///   RT_STATS so a default build carries none of them
+#ifdef RT_ENABLE_STATS
+  #define RT_STATS(...) __VA_ARGS__
+#else
+  #define RT_STATS(...)
+#endif // RT_ENABLE_STATS
+
+enum class StatRay : uint8_t {
+  CAMERA ,
+  /// continuation of a path after a scatter
+  BOUNCE ,
+  /// next event estimation towards a light
+  SHADOW ,
+};
+
+enum class StatPrim : uint8_t {
+  SPHERE ,
+  MOVING_SPHERE ,
+  QUAD ,
+  TRIANGLE ,
+  MEDIUM ,
+  INSTANCE ,
+};
+
+enum class StatMaterial : uint8_t {
+  LAMBERTIAN ,
+  METAL ,
+  DIELECTRIC ,
+  DIFFUSE_LIGHT ,
+  ISOTROPIC ,
+  OTHER ,
+};
+
+enum class StatPhase : uint8_t {
+  /// light sampler and scene compilation
+  BUILD ,
+  TRACE ,
+  /// encoding and writing or flushing the image
+  WRITE ,
+};
+
+/// counters of one render. each thread fills its own copy through ThreadStats , the
+///   camera merges them once the render is done
+class RenderStats {
+  public:
+    static constexpr uint32_t num_ray_types = 3;
+    static constexpr uint32_t num_prim_types = 6;
+    static constexpr uint32_t num_material_types = 6;
+    static constexpr uint32_t num_phases = 3;
+
+    /// rays of depth max_depth and beyond share the last bucket
+    static constexpr uint32_t max_depth = 16;
+
+    uint64_t rays[num_ray_types][max_depth + 1] = {};
+
+    /// nodes whose boxes were tested , light sampler traversals included
+    uint64_t bvh_nodes_visited = 0;
+
+    uint64_t prim_tests[num_prim_types] = {};
+
+    /// closest hits the integrator shaded
+    uint64_t material_hits[num_material_types] = {};
+
+    uint64_t rr_terminations = 0;
+
+    double phase_seconds[num_phases] = {};
+
+    void AddRay(StatRay type , int32_t depth) {
+      uint32_t bucket = (depth < 0) ?
+        0 : (uint32_t(depth) > max_depth ? max_depth : uint32_t(depth));
+      ++rays[uint32_t(type)][bucket];
+    }
+
+    void AddPrimTests(StatPrim type , uint64_t count) {
+      prim_tests[uint32_t(type)] += count;
+    }
+
+    void AddMaterialHit(StatMaterial type) {
+      ++material_hits[uint32_t(type)];
+    }
+
+    void AddTime(StatPhase phase , std::chrono::steady_clock::duration duration) {
+      phase_seconds[uint32_t(phase)] += std::chrono::duration<double>(duration).count();
+    }
+
+    uint64_t NumRays(StatRay type) const;
+    uint64_t NumRays() const;
+
+    uint64_t NumPrimTests() const;
+
+    void Merge(const RenderStats& other);
+
+    /// summary through spdlog
+    void Print() const;
+
+    bool WriteJson(const std::string& file_name) const;
+};
+
+/// counters of the calling thread , registered with the merge on first use
+RenderStats& ThreadStats();
+
+/// zeroes the counters of every thread , call while no render is running
+void ResetThreadStats();
+
+/// sums the counters of every thread , exited ones included. call while no render is running
+RenderStats CollectThreadStats();
+
+#endif // !RENDER_STATS_HPP
@@ -0,0 +1,63 @@
+/**
+ * \file rng.hpp
+ **/
+#ifndef RNG_HPP
+#define RNG_HPP
+
+#include <cstdint>
+
+/// counter based random stream (splitmix64 style). every value is a pure function of
+///   (key , counter) so a stream keyed by (pixel , sample) produces the same numbers
+///   regardless of which thread evaluates it or in which order, and the counter doubles
+///   as the sample dimension
+class Rng {
+  public:
+    constexpr Rng() {}
+    constexpr Rng(uint64_t key , uint64_t counter = 0) 
+      : key(key) , counter(counter) {}
+
+    /// restart the stream for one (pixel , sample) pair at dimension 0
+    void Seed(uint64_t seed , uint64_t pixel , uint64_t sample) {
+      key = Mix(Mix(seed ^ (pixel * 0xd1b54a32d192ed03ull)) ^ (sample * 0xabc98388fb8fac03ull));
+      counter = 0;
+    }
+
+    void SetDimension(uint64_t dimension) {
+      counter = dimension;
+    }
+
+    uint64_t Key() const {
+      return key;
+    }
+
+    uint64_t Dimension() const {
+      return counter;
+    }
+
+    uint64_t NextU64() {
+      return Mix(key + (++counter) * 0x9e3779b97f4a7c15ull);
+    }
+
+    /// uniform in [0 , 1)
+    double NextDouble() {
+      return double(NextU64() >> 11) * 0x1.0p-53;
+    }
+
+    static constexpr uint64_t Mix(uint64_t z) {
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      return z ^ (z >> 31);
+    }
+
+  private:
+    uint64_t key = 0x853c49e6748fea9bull;
+    uint64_t counter = 0;
+};
+
+/// one stream per thread, shared by every translation unit
+inline Rng& ThreadRng() {
+  thread_local Rng rng;
+  return rng;
+}
+
+#endif // !RNG_HPP
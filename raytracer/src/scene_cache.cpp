@@ -0,0 +1,125 @@
+/**
+ * \file scene_cache.cpp
+ **/
+#include "scene_cache.hpp"
+
+#include "compiled_scene.hpp"
+
+/// "RTSC" read as little endian
+static constexpr uint32_t cache_magic = 0x43535452;
+static constexpr uint32_t cache_version = 1;
+
+struct SceneCacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  /// layout of the bvh nodes this build was compiled with
+  uint32_t bvh_width;
+  uint32_t bvh_node_size;
+  uint64_t key;
+  uint64_t data_size;
+};
+
+uint64_t HashBytes(const void* data , size_t size , uint64_t seed) {
+  constexpr uint64_t prime = 0x100000001b3ull;
+
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  uint64_t hash = seed;
+
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word , bytes + i , sizeof(word));
+    hash = (hash ^ word) * prime;
+  }
+
+  for (; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * prime;
+  }
+
+  /// the length goes in last so trailing zero bytes change the hash
+  hash = (hash ^ uint64_t(size)) * prime;
+
+  /// word sized steps leave the high bits poorly mixed , finish with a murmur style avalanche
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdull;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+bool HashFile(const std::string& file_name , uint64_t& hash) {
+  MappedFile file;
+  if (!file.Open(file_name)) {
+    return false;
+  }
+
+  hash = HashBytes(file.Data() , file.Size());
+  return true;
+}
+
+void SceneCacheWriter::Write(const void* src , size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(src);
+  data.insert(data.end() , bytes , bytes + size);
+}
+
+bool SceneCacheWriter::Save(const std::string& file_name , uint64_t key) const {
+  constexpr uint32_t width = WideBvh::default_width;
+  SceneCacheHeader header = { cache_magic , cache_version , width , uint32_t(sizeof(WideBvhNode<width>)) , key , data.size() };
+
+  return WriteFileAtomic(file_name , { { &header , sizeof(header) } , { data.data() , data.size() } } , "scene cache");
+}
+
+size_t SceneCacheWriter::Size() const {
+  return sizeof(SceneCacheHeader) + data.size();
+}
+
+bool SceneCacheReader::Open(const std::string& file_name , uint64_t key) {
+  file.Close();
+  valid = false;
+  offset = 0;
+
+  if (!file.Open(file_name) || file.Size() < sizeof(SceneCacheHeader)) {
+    return false;
+  }
+
+  SceneCacheHeader header;
+  std::memcpy(&header , file.Data() , sizeof(header));
+
+  constexpr uint32_t width = WideBvh::default_width;
+  if (header.magic != cache_magic || header.version != cache_version ||
+      header.bvh_width != width || header.bvh_node_size != sizeof(WideBvhNode<width>) ||
+      header.key != key || header.data_size != file.Size() - sizeof(header)) {
+    file.Close();
+    return false;
+  }
+
+  offset = sizeof(header);
+  valid = true;
+  return true;
+}
+
+bool SceneCacheReader::Read(void* dst , size_t size) {
+  if (!valid || size > Remaining()) {
+    Invalidate();
+    return false;
+  }
+
+  std::memcpy(dst , file.Data() + offset , size);
+  offset += size;
+  return true;
+}
+
+void SceneCacheReader::Invalidate() {
+  valid = false;
+}
+
+bool SceneCacheReader::IsValid() const {
+  return valid;
+}
+
+bool SceneCacheReader::AtEnd() const {
+  return valid && offset == file.Size();
+}
+
+size_t SceneCacheReader::Remaining() const {
+  return file.Size() - offset;
+}
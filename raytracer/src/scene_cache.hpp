@@ -0,0 +1,102 @@
+/**
+ * \file scene_cache.hpp
+ **/
+#ifndef SCENE_CACHE_HPP
+#define SCENE_CACHE_HPP
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "defines.hpp"
+#include "mapped_file.hpp"
+
+/// 64 bit FNV-1a over 8 byte words , fast enough to hash a mesh file in a fraction of the
+///   time it takes to parse it. not stable across endianness , neither is the cache
+uint64_t HashBytes(const void* data , size_t size , uint64_t seed = 0xcbf29ce484222325ull);
+
+/// hash of a whole file , false when it can't be read
+bool HashFile(const std::string& file_name , uint64_t& hash);
+
+/// sections of a scene cache are appended in the order the scene restores them , each one is
+///   the raw bytes of plain values and arrays. nothing is tagged , a reader has to ask for
+///   exactly what was written
+class SceneCacheWriter {
+  public:
+    SceneCacheWriter() {}
+
+    void Write(const void* src , size_t size);
+
+    template <typename T>
+    void Write(const T& value) {
+      static_assert(std::is_trivially_copyable_v<T>);
+      Write(&value , sizeof(T));
+    }
+
+    /// element count followed by the elements
+    template <typename T>
+    void WriteArray(const std::vector<T>& values) {
+      static_assert(std::is_trivially_copyable_v<T>);
+      Write(uint64_t(values.size()));
+      Write(values.data() , values.size() * sizeof(T));
+    }
+
+    /// header with key and the sections , through WriteFileAtomic
+    bool Save(const std::string& file_name , uint64_t key) const;
+
+    size_t Size() const;
+
+  private:
+    std::vector<uint8_t> data{};
+};
+
+/// reads a cache written by SceneCacheWriter straight out of the mapped file. a read past
+///   the end or a mismatch found by the caller invalidates the reader and every later read
+///   fails , so restoring code only has to check once at the end
+class SceneCacheReader {
+  public:
+    SceneCacheReader() {}
+
+    /// false when file_name is missing , from another version or build , or saved for
+    ///   another key
+    bool Open(const std::string& file_name , uint64_t key);
+
+    bool Read(void* dst , size_t size);
+
+    template <typename T>
+    bool Read(T& value) {
+      static_assert(std::is_trivially_copyable_v<T>);
+      return Read(&value , sizeof(T));
+    }
+
+    template <typename T>
+    bool ReadArray(std::vector<T>& values) {
+      static_assert(std::is_trivially_copyable_v<T>);
+
+      uint64_t count = 0;
+      if (!Read(count) || count > Remaining() / sizeof(T)) {
+        Invalidate();
+        return false;
+      }
+
+      values.resize(size_t(count));
+      return Read(values.data() , size_t(count) * sizeof(T));
+    }
+
+    void Invalidate();
+
+    bool IsValid() const;
+
+    /// true once every section has been read
+    bool AtEnd() const;
+
+  private:
+    MappedFile file;
+    size_t offset = 0;
+    bool valid = false;
+
+    size_t Remaining() const;
+};
+
+#endif // !SCENE_CACHE_HPP
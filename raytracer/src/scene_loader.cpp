@@ -0,0 +1,827 @@
+/**
+ * \file scene_loader.cpp
+ **/
+#include "scene_loader.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+
+#include "constant_medium.hpp"
+#include "mapped_file.hpp"
+#include "material.hpp"
+#include "quad.hpp"
+#include "scene_cache.hpp"
+#include "sphere.hpp"
+#include "texture.hpp"
+#include "transform.hpp"
+#include "triangle_mesh.hpp"
+
+/// walks the mapped file once , statements are parsed as their tokens are read so nothing
+///   is copied out of the file except names and paths
+class SceneParser {
+  public:
+    /// meshes are restored from reader while it stays valid , it's null without a cache
+    SceneParser(const std::string& file_name , const char* begin , const char* end , SceneCacheReader* reader)
+      : file_name(file_name) , cur(begin) , end(end) , reader(reader) {}
+
+    bool Parse(SceneDescription& scene);
+
+    size_t NumShapes() const;
+
+    /// every mesh in file order with the hash of its source file , the first sections of a cache
+    void SaveMeshes(SceneCacheWriter& writer) const;
+
+  private:
+    std::string file_name;
+    const char* cur;
+    const char* end;
+    uint32_t line = 1;
+
+    SceneCacheReader* reader;
+
+    struct CachedMesh {
+      uint64_t file_hash;
+      Ref<TriangleMesh> mesh;
+    };
+    std::vector<CachedMesh> meshes{};
+
+    SceneDescription* scene = nullptr;
+
+    std::unordered_map<std::string , Ref<Texture>> textures{};
+    std::unordered_map<std::string , Ref<Material>> materials{};
+    std::unordered_map<std::string , Ref<HittableList>> objects{};
+
+    /// world , or the object between object and end
+    HittableList* target = nullptr;
+    size_t num_shapes = 0;
+
+    /// every statement but camera and output lines , what the world is built from
+    uint64_t world_hash = HashBytes(nullptr , 0);
+
+    /// next token of the current line , false at its end
+    bool Next(std::string_view& token);
+    void SkipLine();
+
+    bool Error(const std::string& message) const;
+
+    /// relative paths are taken from the directory of the scene file , not the working one
+    std::string ResolvePath(std::string_view path) const;
+
+    bool ParseNumber(double& value);
+    bool ParseUint(uint32_t& value);
+    bool ParseVec3(glm::vec3& value);
+    bool ParseName(std::string_view& name , const char* what);
+    /// r g b , or the name of a texture when the first token isn't a number
+    bool ParseColor(Ref<Texture>& texture);
+    bool ParseMaterial(Ref<Material>& mat);
+    bool ParseObject(Ref<HittableList>& object);
+
+    bool ParseStatement(std::string_view keyword);
+    bool ParseCamera();
+    bool ParseTexture();
+    bool ParseMaterialDefinition();
+    bool ParseShape(std::string_view keyword , Ref<Hittable>& shape);
+    bool ParseInstance();
+    bool ParseMedium();
+};
+
+static bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+bool SceneParser::Parse(SceneDescription& scene) {
+  this->scene = &scene;
+  target = scene.world.get();
+
+  bool in_object = false;
+  while (cur < end) {
+    const char* statement = cur;
+
+    std::string_view keyword;
+    if (!Next(keyword)) {
+      SkipLine();
+      continue;
+    }
+
+    if (keyword == "object") {
+      std::string_view name;
+      if (in_object) {
+        return Error("objects can't be nested");
+      }
+      if (!ParseName(name , "object name")) {
+        return false;
+      }
+
+      auto object = NewRef<HittableList>();
+      objects[std::string(name)] = object;
+      target = object.get();
+      in_object = true;
+    } else if (keyword == "end") {
+      if (!in_object) {
+        return Error("end without object");
+      }
+
+      target = scene.world.get();
+      in_object = false;
+    } else if (keyword == "sample") {
+      std::string_view shape_keyword;
+      Ref<Hittable> shape;
+      if (in_object) {
+        return Error("sample inside an object");
+      }
+      if (!ParseName(shape_keyword , "shape") || !ParseShape(shape_keyword , shape)) {
+        return false;
+      }
+
+      if (scene.lights == nullptr) {
+        scene.lights = NewRef<HittableList>();
+      }
+      scene.lights->Add(shape);
+    } else if (!ParseStatement(keyword)) {
+      return false;
+    }
+
+    std::string_view extra;
+    if (Next(extra)) {
+      return Error("unexpected '" + std::string(extra) + "'");
+    }
+    SkipLine();
+
+    /// more samples or another output file still resume the same checkpoint
+    if (keyword != "camera" && keyword != "output") {
+      world_hash = HashBytes(statement , size_t(cur - statement) , world_hash);
+    }
+  }
+
+  if (in_object) {
+    return Error("object without end");
+  }
+
+  scene.camera.scene_hash = world_hash;
+  return true;
+}
+
+size_t SceneParser::NumShapes() const {
+  return num_shapes;
+}
+
+void SceneParser::SaveMeshes(SceneCacheWriter& writer) const {
+  for (const CachedMesh& cached : meshes) {
+    writer.Write(cached.file_hash);
+    cached.mesh->Save(writer);
+  }
+}
+
+bool SceneParser::Next(std::string_view& token) {
+  while (cur < end && IsSpace(*cur)) {
+    ++cur;
+  }
+
+  if (cur >= end || *cur == '\n' || *cur == '#') {
+    return false;
+  }
+
+  const char* start = cur;
+  while (cur < end && !IsSpace(*cur) && *cur != '\n' && *cur != '#') {
+    ++cur;
+  }
+
+  token = std::string_view(start , size_t(cur - start));
+  return true;
+}
+
+void SceneParser::SkipLine() {
+  while (cur < end && *cur != '\n') {
+    ++cur;
+  }
+
+  if (cur < end) {
+    ++cur;
+    ++line;
+  }
+}
+
+bool SceneParser::Error(const std::string& message) const {
+  std::cerr << "ERROR : Failed to parse scene : " << file_name << ":" << line << " : " << message << "\n";
+  return false;
+}
+
+std::string SceneParser::ResolvePath(std::string_view path) const {
+  std::filesystem::path resolved(path);
+  if (resolved.is_relative()) {
+    resolved = std::filesystem::path(file_name).parent_path() / resolved;
+  }
+  return resolved.string();
+}
+
+bool SceneParser::ParseNumber(double& value) {
+  std::string_view token;
+  if (!Next(token)) {
+    return Error("expected a number");
+  }
+
+  auto result = std::from_chars(token.data() , token.data() + token.size() , value);
+  if (result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+    return Error("expected a number , got '" + std::string(token) + "'");
+  }
+
+  return true;
+}
+
+bool SceneParser::ParseUint(uint32_t& value) {
+  std::string_view token;
+  if (!Next(token)) {
+    return Error("expected an integer");
+  }
+
+  auto result = std::from_chars(token.data() , token.data() + token.size() , value);
+  if (result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+    return Error("expected an integer , got '" + std::string(token) + "'");
+  }
+
+  return true;
+}
+
+bool SceneParser::ParseVec3(glm::vec3& value) {
+  double x , y , z;
+  if (!ParseNumber(x) || !ParseNumber(y) || !ParseNumber(z)) {
+    return false;
+  }
+
+  value = glm::vec3(x , y , z);
+  return true;
+}
+
+bool SceneParser::ParseName(std::string_view& name , const char* what) {
+  if (!Next(name)) {
+    return Error(std::string("expected ") + what);
+  }
+
+  return true;
+}
+
+bool SceneParser::ParseColor(Ref<Texture>& texture) {
+  const char* start = cur;
+
+  std::string_view token;
+  if (!Next(token)) {
+    return Error("expected a color or texture");
+  }
+
+  double r;
+  auto result = std::from_chars(token.data() , token.data() + token.size() , r);
+  if (result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+    auto itr = textures.find(std::string(token));
+    if (itr == textures.end()) {
+      return Error("unknown texture '" + std::string(token) + "'");
+    }
+
+    texture = itr->second;
+    return true;
+  }
+
+  cur = start;
+  glm::vec3 rgb;
+  if (!ParseVec3(rgb)) {
+    return false;
+  }
+
+  texture = NewRef<SolidColor>(Color(rgb));
+  return true;
+}
+
+bool SceneParser::ParseMaterial(Ref<Material>& mat) {
+  std::string_view name;
+  if (!ParseName(name , "material")) {
+    return false;
+  }
+
+  auto itr = materials.find(std::string(name));
+  if (itr == materials.end()) {
+    return Error("unknown material '" + std::string(name) + "'");
+  }
+
+  mat = itr->second;
+  return true;
+}
+
+bool SceneParser::ParseObject(Ref<HittableList>& object) {
+  std::string_view name;
+  if (!ParseName(name , "object")) {
+    return false;
+  }
+
+  auto itr = objects.find(std::string(name));
+  if (itr == objects.end()) {
+    return Error("unknown object '" + std::string(name) + "'");
+  }
+
+  object = itr->second;
+  return true;
+}
+
+bool SceneParser::ParseStatement(std::string_view keyword) {
+  if (keyword == "camera") {
+    return ParseCamera();
+  } else if (keyword == "output") {
+    std::string_view file;
+    if (!ParseName(file , "file name")) {
+      return false;
+    }
+
+    scene->camera.img_file = std::string(file);
+    return true;
+  } else if (keyword == "texture") {
+    return ParseTexture();
+  } else if (keyword == "material") {
+    return ParseMaterialDefinition();
+  } else if (keyword == "instance") {
+    return ParseInstance();
+  } else if (keyword == "medium") {
+    return ParseMedium();
+  }
+
+  Ref<Hittable> shape;
+  if (!ParseShape(keyword , shape)) {
+    return false;
+  }
+
+  target->Add(shape);
+  return true;
+}
+
+bool SceneParser::ParseCamera() {
+  Camera& cam = scene->camera;
+
+  std::string_view key;
+  while (Next(key)) {
+    double value = 0.0;
+    glm::vec3 vec;
+
+    if (key == "width") {
+      if (!ParseNumber(value)) {
+        return false;
+      }
+      cam.img_width = value;
+    } else if (key == "aspect") {
+      std::string_view token;
+      if (!Next(token)) {
+        return Error("expected an aspect ratio");
+      }
+
+      /// either a plain number or w/h
+      double w = 0.0 , h = 1.0;
+      const char* token_end = token.data() + token.size();
+      auto result = std::from_chars(token.data() , token_end , w);
+      if (result.ec == std::errc() && result.ptr != token_end && *result.ptr == '/') {
+        result = std::from_chars(result.ptr + 1 , token_end , h);
+      }
+      if (result.ec != std::errc() || result.ptr != token_end || !(h > 0.0)) {
+        return Error("expected an aspect ratio , got '" + std::string(token) + "'");
+      }
+      cam.aspect_ratio = w / h;
+    } else if (key == "spp") {
+      if (!ParseUint(cam.samples_per_pixel)) {
+        return false;
+      }
+    } else if (key == "max_depth") {
+      if (!ParseNumber(value)) {
+        return false;
+      }
+      cam.max_depth = int32_t(value);
+    } else if (key == "background") {
+      if (!ParseVec3(vec)) {
+        return false;
+      }
+      cam.background = Color(vec);
+    } else if (key == "vfov") {
+      if (!ParseNumber(cam.vfov)) {
+        return false;
+      }
+    } else if (key == "from") {
+      if (!ParseVec3(cam.camera_loc)) {
+        return false;
+      }
+    } else if (key == "at") {
+      if (!ParseVec3(cam.target)) {
+        return false;
+      }
+    } else if (key == "up") {
+      if (!ParseVec3(cam.vup)) {
+        return false;
+      }
+    } else if (key == "defocus_angle") {
+      if (!ParseNumber(cam.defocus_angle)) {
+        return false;
+      }
+    } else if (key == "focus_dist") {
+      if (!ParseNumber(cam.focus_dist)) {
+        return false;
+      }
+    } else if (key == "integrator") {
+      std::string_view mode;
+      if (!ParseName(mode , "integrator")) {
+        return false;
+      }
+
+      if (mode == "mis") {
+        cam.integrator = IntegratorMode::MIS;
+      } else if (mode == "iterative") {
+        cam.integrator = IntegratorMode::ITERATIVE;
+      } else if (mode == "recursive") {
+        cam.integrator = IntegratorMode::RECURSIVE;
+      } else {
+        return Error("unknown integrator '" + std::string(mode) + "'");
+      }
+    } else if (key == "light_sampling") {
+      std::string_view mode;
+      if (!ParseName(mode , "light sampling")) {
+        return false;
+      }
+
+      if (mode == "uniform") {
+        cam.light_sampling = LightSampling::UNIFORM;
+      } else if (mode == "power") {
+        cam.light_sampling = LightSampling::POWER;
+      } else if (mode == "bvh") {
+        cam.light_sampling = LightSampling::BVH;
+      } else {
+        return Error("unknown light sampling '" + std::string(mode) + "'");
+      }
+    } else if (key == "adaptive") {
+      if (!ParseNumber(cam.adaptive_threshold)) {
+        return false;
+      }
+      cam.adaptive_sampling = true;
+    } else if (key == "adaptive_min_spp") {
+      if (!ParseUint(cam.adaptive_min_spp)) {
+        return false;
+      }
+    } else if (key == "adaptive_batch_spp") {
+      if (!ParseUint(cam.adaptive_batch_spp)) {
+        return false;
+      }
+    } else if (key == "adaptive_time_budget") {
+      if (!ParseNumber(cam.adaptive_time_budget)) {
+        return false;
+      }
+    } else if (key == "progressive") {
+      if (!ParseUint(cam.samples_per_pass)) {
+        return false;
+      }
+      cam.progressive = true;
+    } else if (key == "progressive_time_budget") {
+      if (!ParseNumber(cam.progressive_time_budget)) {
+        return false;
+      }
+    } else if (key == "progressive_noise") {
+      if (!ParseNumber(cam.progressive_noise_threshold)) {
+        return false;
+      }
+    } else if (key == "output_mode") {
+      std::string_view mode;
+      if (!ParseName(mode , "output mode")) {
+        return false;
+      }
+
+      if (mode == "color") {
+        cam.output_mode = OutputMode::COLOR;
+      } else if (mode == "time") {
+        cam.output_mode = OutputMode::TIME;
+      } else if (mode == "bvh_nodes") {
+        cam.output_mode = OutputMode::BVH_NODES;
+      } else if (mode == "prim_tests") {
+        cam.output_mode = OutputMode::PRIM_TESTS;
+      } else {
+        return Error("unknown output mode '" + std::string(mode) + "'");
+      }
+    } else {
+      return Error("unknown camera setting '" + std::string(key) + "'");
+    }
+  }
+
+  return true;
+}
+
+bool SceneParser::ParseTexture() {
+  std::string_view name , type;
+  if (!ParseName(name , "texture name") || !ParseName(type , "texture type")) {
+    return false;
+  }
+
+  Ref<Texture> texture;
+  if (type == "solid") {
+    glm::vec3 rgb;
+    if (!ParseVec3(rgb)) {
+      return false;
+    }
+    texture = NewRef<SolidColor>(Color(rgb));
+  } else if (type == "checker") {
+    double scale;
+    Ref<Texture> even , odd;
+    if (!ParseNumber(scale) || !ParseColor(even) || !ParseColor(odd)) {
+      return false;
+    }
+    texture = NewRef<CheckerTexture>(scale , even , odd);
+  } else if (type == "image") {
+    std::string_view file;
+    if (!ParseName(file , "image file")) {
+      return false;
+    }
+    texture = NewRef<ImageTexture>(std::string(file));
+  } else if (type == "noise") {
+    double scale;
+    if (!ParseNumber(scale)) {
+      return false;
+    }
+    texture = NewRef<NoiseTexture>(scale);
+  } else {
+    return Error("unknown texture type '" + std::string(type) + "'");
+  }
+
+  textures[std::string(name)] = texture;
+  return true;
+}
+
+bool SceneParser::ParseMaterialDefinition() {
+  std::string_view name , type;
+  if (!ParseName(name , "material name") || !ParseName(type , "material type")) {
+    return false;
+  }
+
+  Ref<Material> mat;
+  Ref<Texture> texture;
+  if (type == "lambertian") {
+    if (!ParseColor(texture)) {
+      return false;
+    }
+    mat = NewRef<Lambertian>(texture);
+  } else if (type == "metal") {
+    glm::vec3 albedo;
+    double fuzz;
+    if (!ParseVec3(albedo) || !ParseNumber(fuzz)) {
+      return false;
+    }
+    mat = NewRef<Metal>(Color(albedo) , fuzz);
+  } else if (type == "dielectric") {
+    double ior;
+    if (!ParseNumber(ior)) {
+      return false;
+    }
+    mat = NewRef<Dielectric>(ior);
+  } else if (type == "light") {
+    if (!ParseColor(texture)) {
+      return false;
+    }
+    mat = NewRef<DiffuseLight>(texture);
+  } else if (type == "isotropic") {
+    if (!ParseColor(texture)) {
+      return false;
+    }
+    mat = NewRef<Isotropic>(texture);
+  } else {
+    return Error("unknown material type '" + std::string(type) + "'");
+  }
+
+  materials[std::string(name)] = mat;
+  return true;
+}
+
+bool SceneParser::ParseShape(std::string_view keyword , Ref<Hittable>& shape) {
+  Ref<Material> mat;
+
+  if (keyword == "sphere") {
+    glm::vec3 center;
+    double radius;
+    if (!ParseMaterial(mat) || !ParseVec3(center) || !ParseNumber(radius)) {
+      return false;
+    }
+    shape = NewRef<Sphere>(center , radius , mat);
+  } else if (keyword == "moving_sphere") {
+    glm::vec3 center1 , center2;
+    double radius;
+    if (!ParseMaterial(mat) || !ParseVec3(center1) || !ParseVec3(center2) || !ParseNumber(radius)) {
+      return false;
+    }
+    shape = NewRef<Sphere>(center1 , center2 , radius , mat);
+  } else if (keyword == "quad") {
+    glm::vec3 q , u , v;
+    if (!ParseMaterial(mat) || !ParseVec3(q) || !ParseVec3(u) || !ParseVec3(v)) {
+      return false;
+    }
+    shape = NewRef<Quad>(q , u , v , mat);
+  } else if (keyword == "box") {
+    glm::vec3 a , b;
+    if (!ParseMaterial(mat) || !ParseVec3(a) || !ParseVec3(b)) {
+      return false;
+    }
+    shape = CreateBox(a , b , mat);
+  } else if (keyword == "mesh") {
+    std::string_view file;
+    if (!ParseMaterial(mat) || !ParseName(file , "mesh file")) {
+      return false;
+    }
+
+    std::string path = ResolvePath(file);
+
+    Ref<TriangleMesh> mesh = nullptr;
+    uint64_t file_hash = 0;
+    if (reader != nullptr && HashFile(path , file_hash) && reader->IsValid()) {
+      uint64_t cached_hash = 0;
+      if (reader->Read(cached_hash) && cached_hash == file_hash) {
+        mesh = TriangleMesh::Load(*reader , mat);
+      } else {
+        reader->Invalidate();
+      }
+    }
+
+    if (mesh == nullptr) {
+      mesh = NewRef<TriangleMesh>(path , mat);
+    }
+
+    if (mesh->NumTriangles() == 0) {
+      return Error("empty mesh '" + std::string(file) + "'");
+    }
+    meshes.push_back({ file_hash , mesh });
+    shape = mesh;
+  } else {
+    return Error("unknown statement '" + std::string(keyword) + "'");
+  }
+
+  ++num_shapes;
+  return true;
+}
+
+bool SceneParser::ParseInstance() {
+  Ref<HittableList> object;
+  if (!ParseObject(object)) {
+    return false;
+  }
+
+  bool has_transform = false;
+  Transform transform;
+
+  std::string_view op;
+  while (Next(op)) {
+    Transform step;
+
+    if (op == "translate") {
+      glm::vec3 offset;
+      if (!ParseVec3(offset)) {
+        return false;
+      }
+      step = Transform::Translate(offset);
+    } else if (op == "rotate_y") {
+      double angle;
+      if (!ParseNumber(angle)) {
+        return false;
+      }
+      step = Transform::RotateY(angle);
+    } else if (op == "rotate") {
+      double angle;
+      glm::vec3 axis;
+      if (!ParseNumber(angle) || !ParseVec3(axis)) {
+        return false;
+      }
+      step = Transform::Rotate(angle , axis);
+    } else if (op == "scale") {
+      /// one factor or three
+      double sx , sy , sz;
+      if (!ParseNumber(sx)) {
+        return false;
+      }
+
+      const char* start = cur;
+      std::string_view token;
+      double value;
+      bool more = Next(token) && std::from_chars(token.data() , token.data() + token.size() , value).ec == std::errc();
+      cur = start;
+
+      if (more) {
+        if (!ParseNumber(sy) || !ParseNumber(sz)) {
+          return false;
+        }
+      } else {
+        sy = sz = sx;
+      }
+      step = Transform::Scale(glm::vec3(sx , sy , sz));
+    } else {
+      return Error("unknown transform '" + std::string(op) + "'");
+    }
+
+    transform = step * transform;
+    has_transform = true;
+  }
+
+  if (has_transform) {
+    target->Add(NewRef<Instance>(object , transform));
+  } else {
+    target->Add(object);
+  }
+
+  return true;
+}
+
+bool SceneParser::ParseMedium() {
+  Ref<HittableList> boundary;
+  double density;
+  Ref<Texture> texture;
+  if (!ParseObject(boundary) || !ParseNumber(density)) {
+    return false;
+  }
+
+  /// the free path is sampled as -log(u) / density
+  if (!(density > 0.0) || !std::isfinite(density)) {
+    return Error("medium density has to be positive and finite");
+  }
+
+  if (!ParseColor(texture)) {
+    return false;
+  }
+
+  target->Add(NewRef<ConstantMedium>(boundary , density , texture));
+  return true;
+}
+
+void SceneDescription::Render() {
+  const Hittable& scene = (compiled != nullptr) ?
+    static_cast<const Hittable&>(*compiled) : *world;
+
+  if (lights != nullptr) {
+    camera.Render(scene , lights);
+  } else {
+    camera.Render(scene);
+  }
+}
+
+bool LoadScene(const std::string& file_name , SceneDescription& scene , const std::string& cache_file) {
+  std::chrono::time_point<std::chrono::steady_clock> before = std::chrono::steady_clock::now();
+
+  MappedFile file;
+  if (!file.Open(file_name)) {
+    std::cerr << "ERROR : Failed to load scene file : " << file_name << "\n";
+    return false;
+  }
+
+  bool caching = !cache_file.empty();
+  uint64_t key = HashBytes(file.Data() , file.Size());
+
+  SceneCacheReader reader;
+  if (caching) {
+    reader.Open(cache_file , key);
+  }
+
+  const char* data = reinterpret_cast<const char*>(file.Data());
+  SceneParser parser(file_name , data , data + file.Size() , caching ? &reader : nullptr);
+  if (!parser.Parse(scene)) {
+    return false;
+  }
+
+  std::chrono::time_point<std::chrono::steady_clock> after = std::chrono::steady_clock::now();
+
+  std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(after - before);
+  std::cout << "Scene-Parse time : [" << duration.count() << "]ms , " << parser.NumShapes() << " shapes from " << file_name << "\n";
+
+  before = std::chrono::steady_clock::now();
+
+  /// the world is walked again to find materials and the objects primitives point to , the
+  ///   bvh builds are what the cache saves
+  bool restored = false;
+  if (reader.IsValid()) {
+    scene.compiled = CompiledScene::Load(Ref<Hittable>(scene.world) , reader);
+    restored = scene.compiled != nullptr && reader.AtEnd();
+  }
+
+  if (!restored) {
+    scene.compiled = NewRef<CompiledScene>(Ref<Hittable>(scene.world));
+  }
+
+  after = std::chrono::steady_clock::now();
+
+  duration = std::chrono::duration_cast<std::chrono::milliseconds>(after - before);
+  std::cout << "Scene-Build time : [" << duration.count() << "]ms" << (restored ? " , restored from " + cache_file : "") << "\n";
+  scene.compiled->PrintSummary();
+
+  if (caching && !restored) {
+    before = std::chrono::steady_clock::now();
+
+    SceneCacheWriter writer;
+    parser.SaveMeshes(writer);
+    scene.compiled->Save(writer);
+    bool saved = writer.Save(cache_file , key);
+
+    after = std::chrono::steady_clock::now();
+
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(after - before);
+    if (saved) {
+      std::cout << "Scene-Cache time : [" << duration.count() << "]ms , " << writer.Size() << " bytes written to " << cache_file << "\n";
+    }
+  }
+
+  return true;
+}
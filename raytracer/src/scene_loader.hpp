@@ -0,0 +1,68 @@
+/**
+ * \file scene_loader.hpp
+ **/
+#ifndef SCENE_LOADER_HPP
+#define SCENE_LOADER_HPP
+
+#include <string>
+
+#include "defines.hpp"
+#include "camera.hpp"
+#include "compiled_scene.hpp"
+#include "hittable_list.hpp"
+
+/// a scene read from a text file , ready to render. the format is one statement per line ,
+///   '#' starts a comment and names have to be defined before they are used
+///
+///   camera <key> <values> ...   width , aspect (a or a/b) , spp , max_depth , background r g b ,
+///                               vfov , from x y z , at x y z , up x y z , defocus_angle ,
+///                               focus_dist , integrator mis|iterative|recursive ,
+///                               light_sampling uniform|power|bvh ,
+///                               output_mode color|time|bvh_nodes|prim_tests ,
+///                               adaptive <threshold> , adaptive_min_spp , adaptive_batch_spp ,
+///                               adaptive_time_budget <seconds> , progressive <spp per pass> ,
+///                               progressive_time_budget <seconds> , progressive_noise <error>
+///   output <file>               written under images/
+///
+///   texture <name> solid r g b | checker <scale> <even> <odd> | image <file> | noise <scale>
+///   material <name> lambertian <color> | metal r g b <fuzz> | dielectric <ior> |
+///                   light <color> | isotropic <color>
+///     where <color> is r g b or the name of a texture
+///
+///   sphere <material> x y z <radius>
+///   moving_sphere <material> x0 y0 z0 x1 y1 z1 <radius>
+///   quad <material> qx qy qz ux uy uz vx vy vz
+///   box <material> x0 y0 z0 x1 y1 z1
+///   mesh <material> <obj or ply file>    relative to the directory of the scene file
+///
+///   object <name> ... end       shapes in between go into the named object instead of the world
+///   instance <object> <ops>     places an object , ops apply left to right : translate x y z ,
+///                               rotate_y <deg> , rotate <deg> ax ay az , scale s | scale x y z.
+///                               without ops the object is added as it is
+///   medium <object> <density> <color>    density positive and finite
+///   sample <shape>              adds the shape to an explicit list of surfaces to sample instead
+///                               of the world , without any the emitters of the world are sampled
+class SceneDescription {
+  public:
+    Ref<HittableList> world = NewRef<HittableList>();
+
+    /// null unless the file has sample statements
+    Ref<HittableList> lights = nullptr;
+
+    /// built from world by LoadScene
+    Ref<CompiledScene> compiled = nullptr;
+
+    Camera camera;
+
+    void Render();
+};
+
+/// parses file_name and compiles its world , reporting both times. on failure the error is
+///   printed with its line and scene is left partially filled.
+///
+/// with a cache_file , mesh buffers and every bvh are restored from it instead of loaded and
+///   built when it was written for the same scene file and mesh files , checked by content
+///   hash. a missing or stale cache is rewritten once the scene is built
+bool LoadScene(const std::string& file_name , SceneDescription& scene , const std::string& cache_file = "");
+
+#endif // !SCENE_LOADER_HPP
@@ -0,0 +1,22 @@
+/**
+ * \file simd.hpp
+ **/
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+/// SSE2 is part of every x64 target , msvc doesn't define __SSE2__ so check the arch too.
+///   AVX paths are only compiled in when the compiler targets them (-mavx2 , /arch:AVX2)
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+  #define RT_SIMD_SSE 1
+  #include <immintrin.h>
+#endif
+
+#if defined(__AVX__)
+  #define RT_SIMD_AVX 1
+#endif
+
+#if defined(__AVX2__)
+  #define RT_SIMD_AVX2 1
+#endif
+
+#endif // !SIMD_HPP
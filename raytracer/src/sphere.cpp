@@ -3,6 +3,11 @@
  **/
 #include "sphere.hpp"
 
+#include "compiled_scene.hpp"
+#include "light_sampler.hpp"
+#include "onb.hpp"
+#include "render_stats.hpp"
+
 Sphere::Sphere(const Point3& center , double radius , Ref<Material> material)
     : center1(center) , radius(fmax(0 , radius)) , material(material) , is_moving(false) {
   auto rvec = glm::vec3(radius , radius , radius);
@@ -21,6 +26,8 @@ Sphere::Sphere(const Point3& center1 , const Point3& center2 , double radius , R
 
 
 bool Sphere::Hit(const Ray& r , Interval rayt , HitRecord& rec) const {
+  RT_STATS(ThreadStats().AddPrimTests(is_moving ? StatPrim::MOVING_SPHERE : StatPrim::SPHERE , 1);)
+
   Point3 center = is_moving ?
     SphereCenter(r.Time()) : center1;
 
@@ -47,12 +54,12 @@ bool Sphere::Hit(const Ray& r , Interval rayt , HitRecord& rec) const {
   rec.t = root;
   rec.point = r.At(rec.t);
 
-  glm::vec3 outward_normal = (rec.point - center1) / radius;
+  glm::vec3 outward_normal = (rec.point - center) / radius;
   rec.SetFaceNormal(r, outward_normal);
 
   GetSphereUV(outward_normal , rec.u , rec.v);
 
-  rec.mat = material;
+  rec.mat = material.get();
 
   return true;
 }
@@ -61,12 +68,64 @@ Aabb Sphere::BoundingBox() const {
   return bbox; 
 }
 
-double Sphere::PdfValue(const Point3& origin , const glm::vec3& direction) const {
-  return 0.0;
+double Sphere::PdfValue(const Point3& origin , const glm::vec3& direction , double time) const {
+  Point3 center = is_moving ?
+    SphereCenter(time) : center1;
+
+  glm::dvec3 oc = glm::dvec3(center - origin);
+  double dist_sqrd = glm::dot(oc , oc);
+  double sin_sqrd = radius * radius / dist_sqrd;
+
+  /// from inside every direction sees the sphere
+  if (sin_sqrd >= 1.0) {
+    return 1.0 / (4 * pi);
+  }
+
+  /// the direction sees the sphere when it falls inside the cone around its silhouette ,
+  ///   testing the cone rather than hitting the surface keeps it consistent with Random
+  glm::dvec3 dir = glm::dvec3(direction);
+  double cos_theta = glm::dot(dir , oc) / std::sqrt(glm::dot(dir , dir) * dist_sqrd);
+  double one_minus_cos_max = OneMinusCosThetaMax(sin_sqrd);
+  if (!(one_minus_cos_max > 0.0) || 1.0 - cos_theta > one_minus_cos_max) {
+    return 0.0;
+  }
+
+  return 1.0 / (2 * pi * one_minus_cos_max);
+}
+
+glm::vec3 Sphere::Random(const Point3& origin , double time) const {
+  Point3 center = is_moving ?
+    SphereCenter(time) : center1;
+
+  glm::vec3 direction = center - origin;
+  double sin_sqrd = radius * radius / LengthSquared(direction);
+
+  if (sin_sqrd >= 1.0) {
+    return RandomUnitVector();
+  }
+
+  /// uniform over the cap of directions that see the sphere , z is measured from the
+  ///   axis towards the center
+  double one_minus_z = RandomDouble() * OneMinusCosThetaMax(sin_sqrd);
+  double z = 1.0 - one_minus_z;
+  double sin_theta = std::sqrt(std::fmax(0.0 , one_minus_z * (2.0 - one_minus_z)));
+  double phi = 2 * pi * RandomDouble();
+
+  Onb uvw;
+  uvw.BuildFromK(direction);
+  return uvw.Local(std::cos(phi) * sin_theta , std::sin(phi) * sin_theta , z);
 }
 
-glm::vec3 Sphere::Random(const Point3& origin) const {
-  return glm::vec3(1 , 0 , 0);
+void Sphere::Compile(SceneCompiler& compiler) const {
+  if (is_moving) {
+    compiler.AddMovingSphere(center1 , center_vec , radius , material);
+  } else {
+    compiler.AddSphere(center1 , radius , material);
+  }
+}
+
+void Sphere::CollectLights(LightCollector& collector) const {
+  collector.AddLight(*this , material.get() , 4.0 * pi * radius * radius);
 }
 
 Point3 Sphere::SphereCenter(double time) const {
@@ -75,6 +134,11 @@ Point3 Sphere::SphereCenter(double time) const {
   return center1 + time * center_vec;
 }
 
+double Sphere::OneMinusCosThetaMax(double sin_sqrd) {
+  /// 1 - sqrt(1 - s) rewritten so small or distant spheres don't cancel to 0
+  return sin_sqrd / (1.0 + std::sqrt(1.0 - sin_sqrd));
+}
+
 void Sphere::GetSphereUV(const Point3& p , double& u , double& v) {
   auto theta = glm::acos(-p.y);
   auto phi = atan2(-p.z , p.x) + pi;
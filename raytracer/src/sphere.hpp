@@ -17,9 +17,17 @@ class Sphere : public Hittable {
 
     virtual Aabb BoundingBox() const override;
     
-    virtual double PdfValue(const Point3& origin , const glm::vec3& direction) const override;
+    /// uniform over the cone of directions from origin that see the sphere , moving
+    ///   spheres are taken where they are at time
+    virtual double PdfValue(const Point3& origin , const glm::vec3& direction , double time) const override;
 
-    virtual glm::vec3 Random(const Point3& origin) const override;
+    virtual glm::vec3 Random(const Point3& origin , double time) const override;
+
+    virtual void Compile(SceneCompiler& compiler) const override;
+
+    virtual void CollectLights(LightCollector& collector) const override;
+
+    static void GetSphereUV(const Point3& p , double& u , double& v);
 
   private:
     Point3 center1;
@@ -33,7 +41,9 @@ class Sphere : public Hittable {
 
     Point3 SphereCenter(double time) const;
 
-    static void GetSphereUV(const Point3& p , double& u , double& v);
+    /// 1 - cos of the half angle of the cone the sphere subtends , sin_sqrd is
+    ///   (radius / distance)^2
+    static double OneMinusCosThetaMax(double sin_sqrd);
 };
 
 #endif // !SPHERE_HPP
@@ -0,0 +1,135 @@
+/**
+ * \file thread_pool.cpp
+ **/
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(uint32_t num_threads) {
+  if (num_threads == 0) {
+    num_threads = std::thread::hardware_concurrency();
+  }
+
+  if (num_threads == 0) {
+    num_threads = 1;
+  }
+
+  queues.reserve(num_threads);
+  for (uint32_t i = 0; i < num_threads; ++i) {
+    queues.push_back(std::make_unique<WorkQueue>());
+  }
+
+  workers.reserve(num_threads);
+  for (uint32_t i = 0; i < num_threads; ++i) {
+    workers.emplace_back(&ThreadPool::WorkerLoop , this , i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::unique_lock lck(job_mtx);
+    shutting_down = true;
+  }
+  job_cv.notify_all();
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+uint32_t ThreadPool::NumWorkers() const {
+  return uint32_t(workers.size());
+}
+
+void ThreadPool::ParallelFor(size_t num_tasks , const TaskFunc& func) {
+  if (num_tasks == 0) {
+    return;
+  }
+
+  std::unique_lock dispatch_lck(dispatch_mtx);
+
+  current_job.store(&func);
+  tasks_remaining.store(num_tasks);
+
+  /// hand out contiguous ranges so spatially close tasks start on the same worker
+  size_t num_queues = queues.size();
+  for (size_t q = 0; q < num_queues; ++q) {
+    size_t first = (q * num_tasks) / num_queues;
+    size_t last = ((q + 1) * num_tasks) / num_queues;
+
+    std::unique_lock lck(queues[q]->mtx);
+    for (size_t t = first; t < last; ++t) {
+      queues[q]->tasks.push_back(t);
+    }
+  }
+
+  {
+    std::unique_lock lck(job_mtx);
+    ++job_generation;
+  }
+  job_cv.notify_all();
+
+  std::unique_lock lck(job_mtx);
+  done_cv.wait(lck , [this]() { return tasks_remaining.load() == 0; });
+
+  current_job.store(nullptr);
+}
+
+void ThreadPool::WorkerLoop(uint32_t idx) {
+  uint64_t seen_generation = 0;
+
+  while (true) {
+    {
+      std::unique_lock lck(job_mtx);
+      job_cv.wait(lck , [this , seen_generation]() { 
+        return shutting_down || job_generation != seen_generation; 
+      });
+
+      if (shutting_down) {
+        return;
+      }
+
+      seen_generation = job_generation;
+    }
+
+    size_t task;
+    while (PopTask(idx , task) || StealTask(idx , task)) {
+      const TaskFunc* job = current_job.load();
+      (*job)(task , idx);
+
+      if (tasks_remaining.fetch_sub(1) == 1) {
+        std::unique_lock lck(job_mtx);
+        done_cv.notify_all();
+      }
+    }
+  }
+}
+
+bool ThreadPool::PopTask(uint32_t idx , size_t& task) {
+  WorkQueue& queue = *queues[idx];
+
+  std::unique_lock lck(queue.mtx);
+  if (queue.tasks.empty()) {
+    return false;
+  }
+
+  task = queue.tasks.front();
+  queue.tasks.pop_front();
+  return true;
+}
+
+bool ThreadPool::StealTask(uint32_t thief , size_t& task) {
+  size_t num_queues = queues.size();
+  for (size_t i = 1; i < num_queues; ++i) {
+    WorkQueue& victim = *queues[(thief + i) % num_queues];
+
+    std::unique_lock lck(victim.mtx);
+    if (victim.tasks.empty()) {
+      continue;
+    }
+
+    task = victim.tasks.back();
+    victim.tasks.pop_back();
+    return true;
+  }
+
+  return false;
+}
@@ -0,0 +1,61 @@
+/**
+ * \file thread_pool.hpp
+ **/
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// persistent pool of worker threads, each owning a deque of task indices.
+///   workers pop from the front of their own deque and steal from the back of
+///   the others once they run dry, so neighbouring tasks stay on one thread
+class ThreadPool {
+  public:
+    using TaskFunc = std::function<void(size_t task , uint32_t worker)>;
+
+    /// num_threads == 0 uses every hardware thread
+    ThreadPool(uint32_t num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    uint32_t NumWorkers() const;
+
+    /// runs func for every task in [0 , num_tasks) and blocks until all of them finished
+    void ParallelFor(size_t num_tasks , const TaskFunc& func);
+
+  private:
+    struct WorkQueue {
+      std::mutex mtx;
+      std::deque<size_t> tasks;
+    };
+
+    std::vector<std::thread> workers{};
+    std::vector<std::unique_ptr<WorkQueue>> queues{};
+
+    std::mutex dispatch_mtx;
+
+    std::mutex job_mtx;
+    std::condition_variable job_cv;
+    std::condition_variable done_cv;
+    uint64_t job_generation = 0;
+    bool shutting_down = false;
+
+    std::atomic<const TaskFunc*> current_job = nullptr;
+    std::atomic<size_t> tasks_remaining = 0;
+
+    void WorkerLoop(uint32_t idx);
+
+    bool PopTask(uint32_t idx , size_t& task);
+    bool StealTask(uint32_t thief , size_t& task);
+};
+
+#endif // !THREAD_POOL_HPP
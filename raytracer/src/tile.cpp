@@ -0,0 +1,65 @@
+/**
+ * \file tile.cpp
+ **/
+#include "tile.hpp"
+
+#include <algorithm>
+
+uint32_t Tile::Width() const {
+  return x1 - x0;
+}
+
+uint32_t Tile::Height() const {
+  return y1 - y0;
+}
+
+uint32_t Tile::NumPixels() const {
+  return Width() * Height();
+}
+
+static uint32_t SpreadBits(uint32_t v) {
+  v &= 0x0000ffff;
+  v = (v | (v << 8)) & 0x00ff00ff;
+  v = (v | (v << 4)) & 0x0f0f0f0f;
+  v = (v | (v << 2)) & 0x33333333;
+  v = (v | (v << 1)) & 0x55555555;
+  return v;
+}
+
+uint32_t MortonEncode2D(uint32_t x , uint32_t y) {
+  return SpreadBits(x) | (SpreadBits(y) << 1);
+}
+
+std::vector<Tile> BuildTiles(uint32_t width , uint32_t height , uint32_t tile_size) {
+  tile_size = std::max(tile_size , 1u);
+
+  uint32_t tiles_x = (width + tile_size - 1) / tile_size;
+  uint32_t tiles_y = (height + tile_size - 1) / tile_size;
+
+  std::vector<std::pair<uint32_t , Tile>> keyed_tiles;
+  keyed_tiles.reserve(tiles_x * tiles_y);
+
+  for (uint32_t ty = 0; ty < tiles_y; ++ty) {
+    for (uint32_t tx = 0; tx < tiles_x; ++tx) {
+      Tile tile;
+      tile.x0 = tx * tile_size;
+      tile.y0 = ty * tile_size;
+      tile.x1 = std::min(tile.x0 + tile_size , width);
+      tile.y1 = std::min(tile.y0 + tile_size , height);
+
+      keyed_tiles.emplace_back(MortonEncode2D(tx , ty) , tile);
+    }
+  }
+
+  std::sort(keyed_tiles.begin() , keyed_tiles.end() , [](const auto& a , const auto& b) {
+    return a.first < b.first;
+  });
+
+  std::vector<Tile> tiles;
+  tiles.reserve(keyed_tiles.size());
+  for (const auto& [key , tile] : keyed_tiles) {
+    tiles.push_back(tile);
+  }
+
+  return tiles;
+}
@@ -0,0 +1,27 @@
+/**
+ * \file tile.hpp
+ **/
+#ifndef TILE_HPP
+#define TILE_HPP
+
+#include <cstdint>
+#include <vector>
+
+/// half-open pixel rectangle [x0 , x1) x [y0 , y1)
+class Tile {
+  public:
+    uint32_t x0 , y0;
+    uint32_t x1 , y1;
+
+    uint32_t Width() const;
+    uint32_t Height() const;
+    uint32_t NumPixels() const;
+};
+
+/// interleaves the bits of x and y (x in the even bits)
+uint32_t MortonEncode2D(uint32_t x , uint32_t y);
+
+/// splits a width x height image into square tiles ordered along a Morton (Z-order) curve
+std::vector<Tile> BuildTiles(uint32_t width , uint32_t height , uint32_t tile_size);
+
+#endif // !TILE_HPP
@@ -0,0 +1,111 @@
+/**
+ * \file transform.cpp
+ **/
+#include "transform.hpp"
+
+static glm::mat4x3 Compose(const glm::mat4x3& a , const glm::mat4x3& b) {
+  glm::mat3 linear = glm::mat3(a) * glm::mat3(b);
+  glm::vec3 translation = glm::mat3(a) * b[3] + a[3];
+  return glm::mat4x3(linear[0] , linear[1] , linear[2] , translation);
+}
+
+Transform::Transform(const glm::mat4x3& to_world)
+    : to_world(to_world) {
+  glm::dmat3 inv_linear = glm::inverse(glm::dmat3(glm::mat3(to_world)));
+  glm::dvec3 inv_translation = -(inv_linear * glm::dvec3(to_world[3]));
+
+  to_object = glm::mat4x3(glm::mat3(inv_linear));
+  to_object[3] = glm::vec3(inv_translation);
+}
+
+Transform Transform::Translate(const glm::vec3& offset) {
+  glm::mat4x3 m(1.0f);
+  m[3] = offset;
+  return Transform(m);
+}
+
+Transform Transform::Rotate(double angle , const glm::vec3& axis) {
+  glm::dvec3 a = glm::normalize(glm::dvec3(axis));
+  double radians = DegreesToRadians(angle);
+  double c = glm::cos(radians);
+  double s = glm::sin(radians);
+  double t = 1.0 - c;
+
+  /// Rodrigues , columns are the rotated basis vectors
+  glm::dmat3 r(
+    t * a.x * a.x + c ,       t * a.x * a.y + s * a.z , t * a.x * a.z - s * a.y ,
+    t * a.x * a.y - s * a.z , t * a.y * a.y + c ,       t * a.y * a.z + s * a.x ,
+    t * a.x * a.z + s * a.y , t * a.y * a.z - s * a.x , t * a.z * a.z + c
+  );
+
+  return Transform(glm::mat4x3(glm::mat3(r)));
+}
+
+Transform Transform::RotateY(double angle) {
+  return Rotate(angle , glm::vec3(0 , 1 , 0));
+}
+
+Transform Transform::Scale(const glm::vec3& scale) {
+  glm::mat4x3 m(1.0f);
+  m[0][0] = scale.x;
+  m[1][1] = scale.y;
+  m[2][2] = scale.z;
+  return Transform(m);
+}
+
+Transform Transform::operator*(const Transform& rhs) const {
+  Transform res;
+  res.to_world = Compose(to_world , rhs.to_world);
+  res.to_object = Compose(rhs.to_object , to_object);
+  return res;
+}
+
+Point3 Transform::PointToWorld(const Point3& p) const {
+  return to_world * glm::vec4(p , 1.0f);
+}
+
+glm::vec3 Transform::VectorToWorld(const glm::vec3& v) const {
+  return glm::mat3(to_world) * v;
+}
+
+glm::vec3 Transform::NormalToWorld(const glm::vec3& n) const {
+  return glm::transpose(glm::mat3(to_object)) * n;
+}
+
+Point3 Transform::PointToObject(const Point3& p) const {
+  return to_object * glm::vec4(p , 1.0f);
+}
+
+glm::vec3 Transform::VectorToObject(const glm::vec3& v) const {
+  return glm::mat3(to_object) * v;
+}
+
+double Transform::DensityToWorld(const glm::vec3& direction) const {
+  glm::dmat3 inv_linear = glm::dmat3(glm::mat3(to_object));
+  glm::dvec3 v = inv_linear * glm::normalize(glm::dvec3(direction));
+  double length = glm::length(v);
+  return glm::abs(glm::determinant(inv_linear)) / (length * length * length);
+}
+
+Aabb Transform::BoxToWorld(const Aabb& box) const {
+  Point3 min(infinity , infinity , infinity);
+  Point3 max(-infinity , -infinity , -infinity);
+
+  for (int32_t i = 0; i < 2; ++i) {
+    for (int32_t j = 0; j < 2; ++j) {
+      for (int32_t k = 0; k < 2; ++k) {
+        Point3 corner(
+          i ? box.x.max : box.x.min ,
+          j ? box.y.max : box.y.min ,
+          k ? box.z.max : box.z.min
+        );
+
+        Point3 p = PointToWorld(corner);
+        min = glm::min(min , p);
+        max = glm::max(max , p);
+      }
+    }
+  }
+
+  return Aabb(min , max);
+}
@@ -0,0 +1,52 @@
+/**
+ * \file transform.hpp
+ **/
+#ifndef TRANSFORM_HPP
+#define TRANSFORM_HPP
+
+#include "defines.hpp"
+#include "aabb.hpp"
+
+/// affine object to world transform stored as a 3x4 matrix together with its inverse ,
+///   the last column is the translation
+class Transform {
+  public:
+    glm::mat4x3 to_world = glm::mat4x3(1.0f);
+    glm::mat4x3 to_object = glm::mat4x3(1.0f);
+
+    Transform() {}
+
+    /// the inverse is computed in double precision
+    Transform(const glm::mat4x3& to_world);
+
+    static Transform Translate(const glm::vec3& offset);
+
+    /// counter clockwise about axis when looking down it , degrees
+    static Transform Rotate(double angle , const glm::vec3& axis);
+    static Transform RotateY(double angle);
+
+    static Transform Scale(const glm::vec3& scale);
+
+    /// applies rhs first
+    Transform operator*(const Transform& rhs) const;
+
+    Point3 PointToWorld(const Point3& p) const;
+    glm::vec3 VectorToWorld(const glm::vec3& v) const;
+
+    /// uses the inverse transpose so normals stay perpendicular under non uniform scale ,
+    ///   the result is not normalized
+    glm::vec3 NormalToWorld(const glm::vec3& n) const;
+
+    Point3 PointToObject(const Point3& p) const;
+    glm::vec3 VectorToObject(const glm::vec3& v) const;
+
+    /// factor a solid angle density of object space directions is multiplied by to become
+    ///   the density of the world directions they map to , |det| / |v|^3 of the inverse with
+    ///   v the unit world direction moved into object space. 1 for rigid transforms
+    double DensityToWorld(const glm::vec3& direction) const;
+
+    /// bounds of the eight transformed corners
+    Aabb BoxToWorld(const Aabb& box) const;
+};
+
+#endif // !TRANSFORM_HPP
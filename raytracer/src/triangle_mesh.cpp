@@ -0,0 +1,299 @@
+/**
+ * \file triangle_mesh.cpp
+ **/
+#include "triangle_mesh.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "light_sampler.hpp"
+#include "mesh_loader.hpp"
+#include "render_stats.hpp"
+#include "scene_cache.hpp"
+
+size_t MeshData::NumTriangles() const {
+  return indices.size() / 3;
+}
+
+WatertightRay::WatertightRay(const Ray& r) {
+  const glm::vec3& dir = r.Direction();
+  for (uint32_t a = 0; a < 3; ++a) {
+    origin[a] = r.Origin()[a];
+  }
+
+  /// z is the dominant axis , swapping x and y keeps the winding when it points backwards
+  glm::vec3 abs_dir = glm::abs(dir);
+  kz = (abs_dir.x > abs_dir.y) ?
+    (abs_dir.x > abs_dir.z ? 0 : 2) : (abs_dir.y > abs_dir.z ? 1 : 2);
+  kx = (kz + 1) % 3;
+  ky = (kx + 1) % 3;
+  if (dir[kz] < 0.0f) {
+    std::swap(kx , ky);
+  }
+
+  sx = dir[kx] / dir[kz];
+  sy = dir[ky] / dir[kz];
+  sz = 1.0f / dir[kz];
+}
+
+TriangleMesh::TriangleMesh(MeshData data , Ref<Material> mat , const BvhBuildOptions& options)
+    : mesh(std::move(data)) , material(mat) {
+  Build(options);
+}
+
+TriangleMesh::TriangleMesh(const std::string& file_name , Ref<Material> mat , const BvhBuildOptions& options)
+    : material(mat) {
+  if (!LoadMesh(file_name , mesh)) {
+    std::cerr << "ERROR : Failed to load mesh file : " << file_name << "\n";
+    mesh = MeshData();
+  }
+
+  Build(options);
+}
+
+TriangleMesh::TriangleMesh(Ref<Material> mat)
+    : material(mat) {}
+
+Ref<TriangleMesh> TriangleMesh::Load(SceneCacheReader& reader , Ref<Material> mat) {
+  Ref<TriangleMesh> result(new TriangleMesh(mat));
+  TriangleMesh& tri_mesh = *result;
+  MeshData& mesh = tri_mesh.mesh;
+
+  if (!reader.ReadArray(mesh.positions) || !reader.ReadArray(mesh.normals) || !reader.ReadArray(mesh.uvs) ||
+      !reader.ReadArray(mesh.indices) || !reader.ReadArray(tri_mesh.nodes) || !reader.ReadArray(tri_mesh.area_cdf) ||
+      !reader.Read(tri_mesh.total_area) || !reader.Read(tri_mesh.bbox)) {
+    return nullptr;
+  }
+
+  /// the same bounds checks a loader does , a damaged cache must not index out of range
+  bool valid = (mesh.normals.empty() || mesh.normals.size() == mesh.positions.size()) &&
+               (mesh.uvs.empty() || mesh.uvs.size() == mesh.positions.size()) &&
+               mesh.indices.size() % 3 == 0 && tri_mesh.area_cdf.size() == mesh.NumTriangles();
+  for (size_t i = 0; valid && i < mesh.indices.size(); ++i) {
+    valid = mesh.indices[i] < mesh.positions.size();
+  }
+  for (size_t n = 0; valid && n < tri_mesh.nodes.size(); ++n) {
+    const auto& node = tri_mesh.nodes[n];
+    for (uint32_t c = 0; valid && c < width; ++c) {
+      valid = (node.prim_count[c] > 0) ?
+        size_t(node.child[c]) + node.prim_count[c] <= mesh.NumTriangles() : node.child[c] < tri_mesh.nodes.size();
+    }
+  }
+
+  if (!valid) {
+    reader.Invalidate();
+    return nullptr;
+  }
+
+  return result;
+}
+
+void TriangleMesh::Save(SceneCacheWriter& writer) const {
+  writer.WriteArray(mesh.positions);
+  writer.WriteArray(mesh.normals);
+  writer.WriteArray(mesh.uvs);
+  writer.WriteArray(mesh.indices);
+  writer.WriteArray(nodes);
+  writer.WriteArray(area_cdf);
+  writer.Write(total_area);
+  writer.Write(bbox);
+}
+
+bool TriangleMesh::Hit(const Ray& r , Interval rayt , HitRecord& rec) const {
+  const WatertightRay ray(r);
+
+  /// traversal only keeps the closest triangle and its edge functions , the surface
+  ///   attributes are interpolated once at the end
+  uint32_t closest = 0;
+  TriangleHit closest_hit;
+
+  auto leaf = [this , &ray , &closest , &closest_hit](uint32_t first , uint32_t count , Interval& ray_t) {
+    bool hit = false;
+    RT_STATS(ThreadStats().AddPrimTests(StatPrim::TRIANGLE , count);)
+    for (uint32_t i = first; i < first + count; ++i) {
+      Point3 p0 , p1 , p2;
+      TrianglePositions(i , p0 , p1 , p2);
+
+      TriangleHit tri_hit;
+      if (!IntersectTriangle(ray , p0 , p1 , p2 , tri_hit)) {
+        continue;
+      }
+
+      double t = double(tri_hit.t_scaled) / double(tri_hit.det);
+      if (!ray_t.OpenContains(t)) {
+        continue;
+      }
+
+      ray_t.max = t;
+      closest = i;
+      closest_hit = tri_hit;
+      hit = true;
+    }
+    return hit;
+  };
+
+  if (!TraverseWideBvh<width>(nodes , r , rayt , leaf)) {
+    return false;
+  }
+
+  const uint32_t* tri = &mesh.indices[3 * closest];
+  const double inv_det = 1.0 / closest_hit.det;
+  const double b0 = closest_hit.u * inv_det;
+  const double b1 = closest_hit.v * inv_det;
+  const double b2 = closest_hit.w * inv_det;
+
+  const Point3& p0 = mesh.positions[tri[0]];
+  const Point3& p1 = mesh.positions[tri[1]];
+  const Point3& p2 = mesh.positions[tri[2]];
+
+  rec.t = rayt.max;
+  rec.point = r.At(rec.t);
+
+  glm::vec3 outward_normal = mesh.normals.empty() ?
+    glm::cross(p1 - p0 , p2 - p0) : b0 * mesh.normals[tri[0]] + b1 * mesh.normals[tri[1]] + b2 * mesh.normals[tri[2]];
+  rec.SetFaceNormal(r , UnitVector(outward_normal));
+
+  if (mesh.uvs.empty()) {
+    rec.u = b1;
+    rec.v = b2;
+  } else {
+    glm::vec2 uv = float(b0) * mesh.uvs[tri[0]] + float(b1) * mesh.uvs[tri[1]] + float(b2) * mesh.uvs[tri[2]];
+    rec.u = uv.x;
+    rec.v = uv.y;
+  }
+
+  rec.mat = material.get();
+  return true;
+}
+
+Aabb TriangleMesh::BoundingBox() const {
+  return bbox;
+}
+
+double TriangleMesh::PdfValue(const Point3& origin , const glm::vec3& direction , double time) const {
+  if (total_area <= 0.0) {
+    return 0.0;
+  }
+
+  const Ray r(origin , direction , time);
+  const WatertightRay ray(r);
+  const double length_sqrd = LengthSquared(direction);
+  const double length = glm::sqrt(length_sqrd);
+
+  /// Random may land on any triangle along the direction , not only the closest , so the
+  ///   solid angle density is the sum of the area densities of every crossing. ray_t is
+  ///   never shrunk and the traversal visits them all
+  double pdf = 0.0;
+  auto leaf = [this , &ray , &direction , &pdf , length_sqrd , length](uint32_t first , uint32_t count , Interval& ray_t) {
+    RT_STATS(ThreadStats().AddPrimTests(StatPrim::TRIANGLE , count);)
+    for (uint32_t i = first; i < first + count; ++i) {
+      Point3 p0 , p1 , p2;
+      TrianglePositions(i , p0 , p1 , p2);
+
+      TriangleHit tri_hit;
+      if (!IntersectTriangle(ray , p0 , p1 , p2 , tri_hit)) {
+        continue;
+      }
+
+      double t = double(tri_hit.t_scaled) / double(tri_hit.det);
+      if (!ray_t.OpenContains(t)) {
+        continue;
+      }
+
+      /// the geometric normal , area is measured on the flat triangle whatever the shading normals
+      glm::vec3 normal = glm::cross(p1 - p0 , p2 - p0);
+      double cosine = std::fabs(glm::dot(direction , normal)) / (length * glm::length(normal));
+      if (cosine > 0.0) {
+        pdf += t * t * length_sqrd / (cosine * total_area);
+      }
+    }
+    return false;
+  };
+
+  Interval rayt(0.001 , infinity);
+  TraverseWideBvh<width>(nodes , r , rayt , leaf);
+  return pdf;
+}
+
+glm::vec3 TriangleMesh::Random(const Point3& origin , double) const {
+  if (area_cdf.empty()) {
+    return glm::vec3(1 , 0 , 0);
+  }
+
+  auto itr = std::upper_bound(area_cdf.begin() , area_cdf.end() , RandomDouble() * total_area);
+  uint32_t tri = uint32_t(std::min<size_t>(itr - area_cdf.begin() , area_cdf.size() - 1));
+
+  Point3 p0 , p1 , p2;
+  TrianglePositions(tri , p0 , p1 , p2);
+
+  /// uniform point on the triangle by folding the unit square
+  double a = RandomDouble();
+  double b = RandomDouble();
+  if (a + b > 1.0) {
+    a = 1.0 - a;
+    b = 1.0 - b;
+  }
+
+  Point3 p = p0 + a * (p1 - p0) + b * (p2 - p0);
+  return p - origin;
+}
+
+void TriangleMesh::CollectLights(LightCollector& collector) const {
+  collector.AddLight(*this , material.get() , total_area);
+}
+
+size_t TriangleMesh::NumTriangles() const {
+  return mesh.NumTriangles();
+}
+
+const BvhBuildStats& TriangleMesh::BuildStats() const {
+  return stats;
+}
+
+void TriangleMesh::Build(const BvhBuildOptions& options) {
+  const size_t num_tris = mesh.NumTriangles();
+
+  std::vector<Aabb> tri_bounds;
+  tri_bounds.reserve(num_tris);
+
+  bbox = Aabb::empty;
+  for (uint32_t i = 0; i < num_tris; ++i) {
+    Point3 p0 , p1 , p2;
+    TrianglePositions(i , p0 , p1 , p2);
+
+    tri_bounds.push_back(Aabb(Aabb(p0 , p1) , Aabb(p2 , p2)));
+    bbox = Aabb(bbox , tri_bounds.back());
+  }
+
+  FlatBvh bvh = BvhBuilder(tri_bounds , options).Build();
+  stats = std::move(bvh.stats);
+  nodes = CollapseBvh<width>(bvh.nodes);
+
+  /// leaf ranges index triangles directly once the index buffer is in leaf order
+  std::vector<uint32_t> sorted_indices;
+  sorted_indices.reserve(mesh.indices.size());
+  for (uint32_t tri : bvh.prim_indices) {
+    sorted_indices.push_back(mesh.indices[3 * tri + 0]);
+    sorted_indices.push_back(mesh.indices[3 * tri + 1]);
+    sorted_indices.push_back(mesh.indices[3 * tri + 2]);
+  }
+  mesh.indices = std::move(sorted_indices);
+
+  area_cdf.clear();
+  area_cdf.reserve(num_tris);
+  total_area = 0.0;
+  for (uint32_t i = 0; i < num_tris; ++i) {
+    Point3 p0 , p1 , p2;
+    TrianglePositions(i , p0 , p1 , p2);
+
+    total_area += 0.5 * glm::length(glm::cross(p1 - p0 , p2 - p0));
+    area_cdf.push_back(total_area);
+  }
+}
+
+void TriangleMesh::TrianglePositions(uint32_t tri , Point3& p0 , Point3& p1 , Point3& p2) const {
+  const uint32_t* idx = &mesh.indices[3 * tri];
+  p0 = mesh.positions[idx[0]];
+  p1 = mesh.positions[idx[1]];
+  p2 = mesh.positions[idx[2]];
+}
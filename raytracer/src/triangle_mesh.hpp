@@ -0,0 +1,149 @@
+/**
+ * \file triangle_mesh.hpp
+ **/
+#ifndef TRIANGLE_MESH_HPP
+#define TRIANGLE_MESH_HPP
+
+#include <string>
+#include <vector>
+
+#include "defines.hpp"
+#include "bvh_builder.hpp"
+#include "hittable.hpp"
+#include "material.hpp"
+#include "wide_bvh.hpp"
+
+class SceneCacheReader;
+class SceneCacheWriter;
+
+/// indexed triangle soup as it comes out of a loader , attributes are shared between the
+///   triangles that reference the same vertex
+class MeshData {
+  public:
+    std::vector<Point3> positions{};
+
+    /// optional , either empty or one per position
+    std::vector<glm::vec3> normals{};
+    std::vector<glm::vec2> uvs{};
+
+    /// three per triangle
+    std::vector<uint32_t> indices{};
+
+    size_t NumTriangles() const;
+};
+
+/// per-ray constants of the watertight ray/triangle test (Woop , Benthin , Wald 2013). the
+///   ray is sheared so it points down +z of a permuted frame , which turns the triangle
+///   test into a 2d edge function test without any per triangle division
+class WatertightRay {
+  public:
+    float origin[3];
+    uint32_t kx , ky , kz;
+    float sx , sy , sz;
+
+    WatertightRay(const Ray& r);
+};
+
+/// edge functions of a candidate hit , all three share the sign of det for hits inside
+class TriangleHit {
+  public:
+    float u , v , w;
+    float det;
+    float t_scaled;
+};
+
+/// tests the triangle p0 p1 p2. edges shared by two triangles are never missed by both ,
+///   edge functions that come out exactly 0 in float are redone in double
+inline bool IntersectTriangle(const WatertightRay& ray , const Point3& p0 , const Point3& p1 , const Point3& p2 , TriangleHit& hit) {
+  const float ax = p0[ray.kx] - ray.origin[ray.kx] , ay = p0[ray.ky] - ray.origin[ray.ky] , az = p0[ray.kz] - ray.origin[ray.kz];
+  const float bx = p1[ray.kx] - ray.origin[ray.kx] , by = p1[ray.ky] - ray.origin[ray.ky] , bz = p1[ray.kz] - ray.origin[ray.kz];
+  const float cx = p2[ray.kx] - ray.origin[ray.kx] , cy = p2[ray.ky] - ray.origin[ray.ky] , cz = p2[ray.kz] - ray.origin[ray.kz];
+
+  const float sax = ax - ray.sx * az , say = ay - ray.sy * az;
+  const float sbx = bx - ray.sx * bz , sby = by - ray.sy * bz;
+  const float scx = cx - ray.sx * cz , scy = cy - ray.sy * cz;
+
+  float u = scx * sby - scy * sbx;
+  float v = sax * scy - say * scx;
+  float w = sbx * say - sby * sax;
+
+  if (u == 0.0f || v == 0.0f || w == 0.0f) {
+    u = float(double(scx) * double(sby) - double(scy) * double(sbx));
+    v = float(double(sax) * double(scy) - double(say) * double(scx));
+    w = float(double(sbx) * double(say) - double(sby) * double(sax));
+  }
+
+  if ((u < 0.0f || v < 0.0f || w < 0.0f) && (u > 0.0f || v > 0.0f || w > 0.0f)) {
+    return false;
+  }
+
+  const float det = u + v + w;
+  if (det == 0.0f) {
+    return false;
+  }
+
+  hit.u = u;
+  hit.v = v;
+  hit.w = w;
+  hit.det = det;
+  hit.t_scaled = u * (ray.sz * az) + v * (ray.sz * bz) + w * (ray.sz * cz);
+  return true;
+}
+
+/// Hittable over a whole indexed mesh with one material. triangles are referenced by
+///   index into shared vertex buffers and accelerated by a wide bvh built over the
+///   triangles themselves , so a mesh is a single object to the rest of the scene
+class TriangleMesh : public Hittable {
+  public:
+    TriangleMesh(MeshData data , Ref<Material> mat , const BvhBuildOptions& options = BvhBuildOptions());
+
+    /// loads an .obj or binary .ply file , reports and stays empty if that fails
+    TriangleMesh(const std::string& file_name , Ref<Material> mat , const BvhBuildOptions& options = BvhBuildOptions());
+
+    /// restores what Save wrote , null when the cache runs out or doesn't hold a mesh here
+    static Ref<TriangleMesh> Load(SceneCacheReader& reader , Ref<Material> mat);
+
+    /// vertex buffers in leaf order and the bvh over them , everything Build computes
+    void Save(SceneCacheWriter& writer) const;
+
+    virtual bool Hit(const Ray& r , Interval rayt , HitRecord& rec) const override;
+
+    virtual Aabb BoundingBox() const override;
+
+    /// triangles are sampled proportional to their area , hidden and back facing ones
+    ///   included , so the pdf of a direction adds up every triangle it passes through
+    virtual double PdfValue(const Point3& origin , const glm::vec3& direction , double time) const override;
+
+    virtual glm::vec3 Random(const Point3& origin , double time) const override;
+
+    virtual void CollectLights(LightCollector& collector) const override;
+
+    size_t NumTriangles() const;
+
+    const BvhBuildStats& BuildStats() const;
+
+  private:
+    static constexpr uint32_t width = WideBvh::default_width;
+
+    /// triangle indices are stored in leaf order
+    MeshData mesh;
+    Ref<Material> material;
+
+    std::vector<WideBvhNode<width>> nodes{};
+
+    /// running sum of triangle areas in leaf order
+    std::vector<double> area_cdf{};
+    double total_area = 0.0;
+
+    Aabb bbox;
+
+    BvhBuildStats stats;
+
+    TriangleMesh(Ref<Material> mat);
+
+    void Build(const BvhBuildOptions& options);
+
+    void TrianglePositions(uint32_t tri , Point3& p0 , Point3& p1 , Point3& p2) const;
+};
+
+#endif // !TRIANGLE_MESH_HPP
@@ -0,0 +1,186 @@
+/**
+ * \file wide_bvh.cpp
+ **/
+#include "wide_bvh.hpp"
+
+#include <array>
+
+#include "compiled_scene.hpp"
+#include "light_sampler.hpp"
+
+static double NodeSurfaceArea(const LinearBvhNode& node) {
+  double dx = double(node.bounds[1][0]) - node.bounds[0][0];
+  double dy = double(node.bounds[1][1]) - node.bounds[0][1];
+  double dz = double(node.bounds[1][2]) - node.bounds[0][2];
+  return 2.0 * (dx * dy + dy * dz + dz * dx);
+}
+
+template <uint32_t N>
+static uint32_t CollapseNode(const std::vector<LinearBvhNode>& binary , uint32_t idx , std::vector<WideBvhNode<N>>& out) {
+  uint32_t out_idx = uint32_t(out.size());
+  out.emplace_back();
+
+  std::array<uint32_t , N> kids;
+  uint32_t num_kids = 0;
+
+  if (binary[idx].IsLeaf()) {
+    kids[num_kids++] = idx;
+  } else {
+    kids[num_kids++] = idx + 1;
+    kids[num_kids++] = binary[idx].offset;
+  }
+
+  while (num_kids < N) {
+    int32_t widest = -1;
+    double widest_area = -1.0;
+    for (uint32_t i = 0; i < num_kids; ++i) {
+      const LinearBvhNode& kid = binary[kids[i]];
+      if (!kid.IsLeaf() && NodeSurfaceArea(kid) > widest_area) {
+        widest = int32_t(i);
+        widest_area = NodeSurfaceArea(kid);
+      }
+    }
+
+    if (widest < 0) {
+      break;
+    }
+
+    uint32_t opened = kids[widest];
+    kids[widest] = opened + 1;
+    kids[num_kids++] = binary[opened].offset;
+  }
+
+  for (uint32_t lane = 0; lane < N; ++lane) {
+    WideBvhNode<N>& node = out[out_idx];
+
+    if (lane >= num_kids) {
+      for (uint32_t a = 0; a < 3; ++a) {
+        node.bounds[0][a][lane] = std::numeric_limits<float>::infinity();
+        node.bounds[1][a][lane] = -std::numeric_limits<float>::infinity();
+      }
+      node.child[lane] = 0;
+      node.prim_count[lane] = 0;
+      continue;
+    }
+
+    const LinearBvhNode& kid = binary[kids[lane]];
+    for (uint32_t a = 0; a < 3; ++a) {
+      node.bounds[0][a][lane] = kid.bounds[0][a];
+      node.bounds[1][a][lane] = kid.bounds[1][a];
+    }
+
+    if (kid.IsLeaf()) {
+      node.child[lane] = kid.offset;
+      node.prim_count[lane] = kid.prim_count;
+    } else {
+      /// out grows during the recursion , so don't hold on to node across it
+      uint32_t child_idx = CollapseNode<N>(binary , kids[lane] , out);
+      out[out_idx].child[lane] = child_idx;
+      out[out_idx].prim_count[lane] = 0;
+    }
+  }
+
+  return out_idx;
+}
+
+template <uint32_t N>
+std::vector<WideBvhNode<N>> CollapseBvh(const std::vector<LinearBvhNode>& binary) {
+  std::vector<WideBvhNode<N>> wide;
+  if (binary.empty()) {
+    return wide;
+  }
+
+  wide.reserve(binary.size() / (N - 1) + 1);
+  CollapseNode<N>(binary , 0 , wide);
+  return wide;
+}
+
+template std::vector<WideBvhNode<4>> CollapseBvh<4>(const std::vector<LinearBvhNode>& binary);
+template std::vector<WideBvhNode<8>> CollapseBvh<8>(const std::vector<LinearBvhNode>& binary);
+
+WideBvh::WideBvh(const std::vector<Ref<Hittable>>& objects , uint32_t width , const BvhBuildOptions& options)
+    : width(width == 8 ? 8 : 4) {
+  std::vector<Aabb> prim_bounds;
+  prim_bounds.reserve(objects.size());
+
+  bbox = Aabb::empty;
+  for (const auto& obj : objects) {
+    prim_bounds.push_back(obj->BoundingBox());
+    bbox = Aabb(bbox , prim_bounds.back());
+  }
+
+  FlatBvh bvh = BvhBuilder(prim_bounds , options).Build();
+  stats = std::move(bvh.stats);
+
+  if (this->width == 8) {
+    nodes8 = CollapseBvh<8>(bvh.nodes);
+  } else {
+    nodes4 = CollapseBvh<4>(bvh.nodes);
+  }
+
+  primitives.reserve(objects.size());
+  for (uint32_t idx : bvh.prim_indices) {
+    primitives.push_back(objects[idx]);
+  }
+}
+
+bool WideBvh::Hit(const Ray& r , Interval rayt , HitRecord& rec) const {
+  auto leaf = [this , &r , &rec](uint32_t first , uint32_t count , Interval& ray_t) {
+    bool hit = false;
+    for (uint32_t i = first; i < first + count; ++i) {
+      if (primitives[i]->Hit(r , ray_t , rec)) {
+        hit = true;
+        ray_t.max = rec.t;
+      }
+    }
+    return hit;
+  };
+
+  return width == 8 ?
+    TraverseWideBvh<8>(nodes8 , r , rayt , leaf) : TraverseWideBvh<4>(nodes4 , r , rayt , leaf);
+}
+
+Aabb WideBvh::BoundingBox() const {
+  return bbox;
+}
+
+double WideBvh::PdfValue(const Point3& origin , const glm::vec3& direction , double time) const {
+  auto weight = 1.0 / primitives.size();
+  auto sum = 0.0;
+
+  for (const auto& prim : primitives) {
+    sum += weight * prim->PdfValue(origin , direction , time);
+  }
+
+  return sum;
+}
+
+glm::vec3 WideBvh::Random(const Point3& origin , double time) const {
+  auto int_size = int32_t(primitives.size());
+  return primitives[RandomInt(0 , int_size - 1)]->Random(origin , time);
+}
+
+void WideBvh::Compile(SceneCompiler& compiler) const {
+  for (const auto& obj : primitives) {
+    obj->Compile(compiler);
+  }
+}
+
+void WideBvh::CollectLights(LightCollector& collector) const {
+  for (const auto& obj : primitives) {
+    obj->CollectLights(collector);
+  }
+}
+
+uint32_t WideBvh::Width() const {
+  return width;
+}
+
+size_t WideBvh::NumNodes() const {
+  return width == 8 ?
+    nodes8.size() : nodes4.size();
+}
+
+const BvhBuildStats& WideBvh::BuildStats() const {
+  return stats;
+}
@@ -0,0 +1,257 @@
+/**
+ * \file wide_bvh.hpp
+ **/
+#ifndef WIDE_BVH_HPP
+#define WIDE_BVH_HPP
+
+#include <bit>
+#include <vector>
+
+#include "defines.hpp"
+#include "simd.hpp"
+#include "bvh_builder.hpp"
+#include "hittable.hpp"
+#include "hittable_list.hpp"
+#include "linear_bvh.hpp"
+#include "render_stats.hpp"
+
+/// node of an N-wide bvh. child boxes are stored as structure of arrays so a single
+///   slab test covers every child , unused lanes hold an inverted box that never hits
+template <uint32_t N>
+struct alignas(sizeof(float) * N) WideBvhNode {
+  /// [0] = min corner , [1] = max corner , then axis , then child lane
+  float bounds[2][3][N];
+
+  /// interior child : node index , leaf child : index of the first primitive
+  uint32_t child[N];
+
+  /// 0 for interior children and unused lanes
+  uint32_t prim_count[N];
+};
+
+/// returns a mask of the children whose box overlaps [t_min , t_max] and writes their
+///   entry distances to t_near. same NaN and rounding rules as IntersectNode
+template <uint32_t N>
+inline uint32_t IntersectWideNode(const WideBvhNode<N>& node , const BvhRay& ray , float t_min , float t_max , float* t_near) {
+  float lane_min[N];
+  float lane_max[N];
+  for (uint32_t i = 0; i < N; ++i) {
+    lane_min[i] = t_min;
+    lane_max[i] = t_max;
+  }
+
+  for (uint32_t a = 0; a < 3; ++a) {
+    const float* near_plane = node.bounds[ray.dir_is_neg[a]][a];
+    const float* far_plane = node.bounds[1 - ray.dir_is_neg[a]][a];
+
+    for (uint32_t i = 0; i < N; ++i) {
+      float tn = (near_plane[i] - ray.origin[a]) * ray.inv_dir[a];
+      float tf = (far_plane[i] - ray.origin[a]) * ray.inv_dir[a];
+      tf *= 1.0f + 2.0f * 3.0f * std::numeric_limits<float>::epsilon();
+
+      if (tn > lane_min[i]) lane_min[i] = tn;
+      if (tf < lane_max[i]) lane_max[i] = tf;
+    }
+  }
+
+  uint32_t mask = 0;
+  for (uint32_t i = 0; i < N; ++i) {
+    t_near[i] = lane_min[i];
+    if (lane_min[i] <= lane_max[i]) {
+      mask |= 1u << i;
+    }
+  }
+
+  return mask;
+}
+
+#ifdef RT_SIMD_SSE
+/// max_ps/min_ps return their second operand when either is NaN , so the running
+///   interval goes second and a NaN slab distance leaves it untouched
+template <>
+inline uint32_t IntersectWideNode<4>(const WideBvhNode<4>& node , const BvhRay& ray , float t_min , float t_max , float* t_near) {
+  const __m128 pad = _mm_set1_ps(1.0f + 2.0f * 3.0f * std::numeric_limits<float>::epsilon());
+
+  __m128 lane_min = _mm_set1_ps(t_min);
+  __m128 lane_max = _mm_set1_ps(t_max);
+
+  for (uint32_t a = 0; a < 3; ++a) {
+    const __m128 origin = _mm_set1_ps(ray.origin[a]);
+    const __m128 inv_dir = _mm_set1_ps(ray.inv_dir[a]);
+
+    __m128 tn = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bounds[ray.dir_is_neg[a]][a]) , origin) , inv_dir);
+    __m128 tf = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bounds[1 - ray.dir_is_neg[a]][a]) , origin) , inv_dir);
+    tf = _mm_mul_ps(tf , pad);
+
+    lane_min = _mm_max_ps(tn , lane_min);
+    lane_max = _mm_min_ps(tf , lane_max);
+  }
+
+  _mm_storeu_ps(t_near , lane_min);
+  return uint32_t(_mm_movemask_ps(_mm_cmple_ps(lane_min , lane_max)));
+}
+#endif // RT_SIMD_SSE
+
+#ifdef RT_SIMD_AVX2
+template <>
+inline uint32_t IntersectWideNode<8>(const WideBvhNode<8>& node , const BvhRay& ray , float t_min , float t_max , float* t_near) {
+  const __m256 pad = _mm256_set1_ps(1.0f + 2.0f * 3.0f * std::numeric_limits<float>::epsilon());
+
+  __m256 lane_min = _mm256_set1_ps(t_min);
+  __m256 lane_max = _mm256_set1_ps(t_max);
+
+  for (uint32_t a = 0; a < 3; ++a) {
+    const __m256 origin = _mm256_set1_ps(ray.origin[a]);
+    const __m256 inv_dir = _mm256_set1_ps(ray.inv_dir[a]);
+
+    __m256 tn = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node.bounds[ray.dir_is_neg[a]][a]) , origin) , inv_dir);
+    __m256 tf = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node.bounds[1 - ray.dir_is_neg[a]][a]) , origin) , inv_dir);
+    tf = _mm256_mul_ps(tf , pad);
+
+    lane_min = _mm256_max_ps(tn , lane_min);
+    lane_max = _mm256_min_ps(tf , lane_max);
+  }
+
+  _mm256_storeu_ps(t_near , lane_min);
+  return uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(lane_min , lane_max , _CMP_LE_OQ)));
+}
+#endif // RT_SIMD_AVX2
+
+/// front-to-back traversal of an N-wide bvh , hit children are pushed far to near so the
+///   closest one is visited next. leaf has the same contract as in TraverseLinearBvh
+template <uint32_t N , typename LeafFunc>
+inline bool TraverseWideBvh(const std::vector<WideBvhNode<N>>& nodes , const Ray& r , Interval& rayt , LeafFunc&& leaf) {
+  if (nodes.empty()) {
+    return false;
+  }
+
+  BvhRay ray(r);
+
+  struct StackEntry {
+    uint32_t child;
+    uint32_t prim_count;
+    float t_near;
+  };
+
+  /// BvhBuilder::max_depth (64) caps the binary tree , collapsing only shortens paths so a
+  ///   wide path has at most that many nodes. each node on it continues into one child and
+  ///   leaves at most N - 1 siblings on the stack , so max_depth * (N - 1) + 1 entries never
+  ///   overflow
+  StackEntry stack[BvhBuilder::max_depth * (N - 1) + 1];
+  uint32_t stack_size = 0;
+  uint32_t current = 0;
+  bool hit_anything = false;
+  RT_STATS(uint64_t nodes_visited = 0;)
+
+  while (true) {
+    const WideBvhNode<N>& node = nodes[current];
+    RT_STATS(++nodes_visited;)
+
+    float t_near[N];
+    uint32_t mask = IntersectWideNode<N>(node , ray , float(rayt.min) , float(rayt.max) , t_near);
+
+    /// insertion sort the hit children by descending distance
+    StackEntry hits[N];
+    uint32_t num_hits = 0;
+    while (mask != 0) {
+      uint32_t lane = uint32_t(std::countr_zero(mask));
+      mask &= mask - 1;
+
+      StackEntry entry = { node.child[lane] , node.prim_count[lane] , t_near[lane] };
+      uint32_t i = num_hits++;
+      while (i > 0 && hits[i - 1].t_near < entry.t_near) {
+        hits[i] = hits[i - 1];
+        --i;
+      }
+      hits[i] = entry;
+    }
+
+    for (uint32_t i = 0; i < num_hits; ++i) {
+      stack[stack_size++] = hits[i];
+    }
+
+    bool found_node = false;
+    while (stack_size > 0) {
+      const StackEntry entry = stack[--stack_size];
+
+      /// a closer hit was found after this child was pushed
+      if (entry.t_near > rayt.max) {
+        continue;
+      }
+
+      if (entry.prim_count > 0) {
+        if (leaf(entry.child , entry.prim_count , rayt)) {
+          hit_anything = true;
+        }
+        continue;
+      }
+
+      current = entry.child;
+      found_node = true;
+      break;
+    }
+
+    if (!found_node) {
+      break;
+    }
+  }
+
+  RT_STATS(ThreadStats().bvh_nodes_visited += nodes_visited;)
+
+  return hit_anything;
+}
+
+/// collapses a flattened binary bvh into an N-wide one by repeatedly opening the
+///   interior child with the largest surface area until a node has N children
+template <uint32_t N>
+std::vector<WideBvhNode<N>> CollapseBvh(const std::vector<LinearBvhNode>& binary);
+
+/// Hittable over a 4 or 8 wide bvh collapsed from the output of BvhBuilder
+class WideBvh : public Hittable {
+  public:
+#ifdef RT_SIMD_AVX2
+    static constexpr uint32_t default_width = 8;
+#else
+    static constexpr uint32_t default_width = 4;
+#endif
+
+    WideBvh(HittableList list , uint32_t width = default_width , const BvhBuildOptions& options = BvhBuildOptions())
+      : WideBvh(list.objects , width , options) {}
+
+    WideBvh(const std::vector<Ref<Hittable>>& objects , uint32_t width = default_width ,
+            const BvhBuildOptions& options = BvhBuildOptions());
+
+    virtual bool Hit(const Ray& r , Interval rayt , HitRecord& rec) const override;
+
+    virtual Aabb BoundingBox() const override;
+
+    virtual double PdfValue(const Point3& origin , const glm::vec3& direction , double time) const override;
+
+    virtual glm::vec3 Random(const Point3& origin , double time) const override;
+
+    virtual void Compile(SceneCompiler& compiler) const override;
+
+    virtual void CollectLights(LightCollector& collector) const override;
+
+    uint32_t Width() const;
+
+    size_t NumNodes() const;
+
+    const BvhBuildStats& BuildStats() const;
+
+  private:
+    uint32_t width;
+
+    /// only the one matching width is filled
+    std::vector<WideBvhNode<4>> nodes4{};
+    std::vector<WideBvhNode<8>> nodes8{};
+
+    /// primitives in leaf order
+    std::vector<Ref<Hittable>> primitives{};
+
+    Aabb bbox;
+
+    BvhBuildStats stats;
+};
+
+#endif // !WIDE_BVH_HPP